@@ -0,0 +1,143 @@
+/*
+ *  Libstropt: an easy to use library about command-line options parsing
+ *  Copyright (C) 2010 Paul Bazin
+ *
+ *  This file is part of Libstrotp.
+ *
+ *  This libray is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ *  @file
+ *  Allocator.
+ *  @author Paul Bazin
+ *  @date 2010
+ *  @version 0.9-a2
+ *
+ *  This file contains the functions through which the library
+ *  allocates all its memory, and those setting the allocator they use.
+ */
+
+#include "stropt.h"
+
+void* smalloc(size_t);
+void* srealloc(void*, size_t);
+void sfree(void*);
+
+static void* std_alloc(void* ctx, size_t size)
+{
+    (void)ctx;
+    return malloc(size);
+}
+
+static void* std_resize(void* ctx, void* ptr, size_t size)
+{
+    (void)ctx;
+    return realloc(ptr, size);
+}
+
+static void std_release(void* ctx, void* ptr)
+{
+    (void)ctx;
+    free(ptr);
+}
+
+static struct atralloc allocator = {std_alloc, std_resize, std_release, NULL};
+
+/* Begin debug functions */
+
+static struct atralloc debug_next;
+static int debug_rate;
+
+static void* debug_alloc(void* ctx, size_t size)
+{
+    (void)ctx;
+    if (rand()%debug_rate)
+        return debug_next.alloc(debug_next.ctx, size);
+    return NULL;
+}
+
+static void* debug_resize(void* ctx, void* ptr, size_t size)
+{
+    (void)ctx;
+    if (rand()%debug_rate)
+        return debug_next.resize(debug_next.ctx, ptr, size);
+    return NULL;
+}
+
+static void debug_release(void* ctx, void* ptr)
+{
+    (void)ctx;
+    debug_next.release(debug_next.ctx, ptr);
+}
+
+/* End debug functions */
+
+void* smalloc(size_t size)
+{
+    return allocator.alloc(allocator.ctx, size);
+}
+
+void* srealloc(void* ptr, size_t size)
+{
+    if (!ptr)
+        return allocator.alloc(allocator.ctx, size);
+    return allocator.resize(allocator.ctx, ptr, size);
+}
+
+void sfree(void* ptr)
+{
+    if (ptr)
+        allocator.release(allocator.ctx, ptr);
+}
+
+/** Sets the allocator of the library.
+ *  All the memory the library allocates, for the options, indexes,
+ *  return and result structures, arenas and response files, is then
+ *  allocated, reallocated and freed by the functions of alloc, each
+ *  being given its ctx member as first argument. The resize and
+ *  release functions are never given a NULL pointer: a first
+ *  allocation always goes through the alloc function. The allocator
+ *  must not be changed while the library holds memory allocated by the
+ *  previous one, nor while a parse is running in another thread.
+ *  @param[in] alloc The allocator, copied; or NULL to restore the
+ *  default one, using malloc, realloc and free.
+ */
+void set_allocator(const struct atralloc* alloc)
+{
+    if (alloc)
+        allocator=*alloc;
+    else
+    {
+        allocator.alloc=std_alloc;
+        allocator.resize=std_resize;
+        allocator.release=std_release;
+        allocator.ctx=NULL;
+    }
+}
+
+/** Makes allocations fail randomly, to debug failure paths.
+ *  Once this function is called, about one allocation or reallocation
+ *  in rate fails, according to rand(); the others are passed to the
+ *  allocator set beforehand. Call set_allocator to stop.
+ *  @param[in] rate The inverse of the failure rate, at least 1.
+ */
+void set_debug_allocator(int rate)
+{
+    static const struct atralloc debug = {debug_alloc, debug_resize, debug_release, NULL};
+    if (allocator.alloc != debug_alloc)
+        debug_next=allocator;
+    debug_rate = rate > 0 ? rate : 1;
+    allocator=debug;
+}
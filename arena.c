@@ -0,0 +1,189 @@
+/*
+ *  Libstropt: an easy to use library about command-line options parsing
+ *  Copyright (C) 2010 Paul Bazin
+ *
+ *  This file is part of Libstrotp.
+ *
+ *  This libray is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ *  @file
+ *  Arenas.
+ *  @author Paul Bazin
+ *  @date 2010
+ *  @version 0.9-a2
+ *
+ *  This file contains the functions managing arenas: regions from
+ *  which a whole parse allocates by bumping a pointer, and which are
+ *  freed in one call.
+ */
+
+#include "stropt.h"
+#include "arena.h"
+
+void* smalloc(size_t);
+void* srealloc(void*, size_t);
+void sfree(void*);
+
+/* Most restrictive alignment needed by the data put in an arena. */
+union align
+{
+    long l;
+    double d;
+    void* p;
+};
+
+#define ALIGN (sizeof(union align))
+#define ROUND(n) (((n)+ALIGN-1)/ALIGN*ALIGN)
+
+struct arblock
+{
+    struct arblock* next;
+    size_t size;
+    size_t used;
+};
+
+struct arena
+{
+    struct arblock* head;
+    size_t block;
+    char* last;
+};
+
+/* Returns the data of a block, which follow its header. */
+#define DATA(b) ((char*) (b) + ROUND(sizeof(struct arblock)))
+
+/** Creates an arena.
+ *  An arena is a region from which atropt_conf can take all the memory
+ *  needed by a parse: the rtrn structure and the values copied into
+ *  the option structures. Instead of freeing each of them, you free
+ *  everything at once calling delete_arena. The arena grows by blocks,
+ *  the size of each new block doubling the size of the previous one.
+ *  @param[in] size The size of the first block, in bytes; 0 for a
+ *  default size.
+ *  @return A pointer to the newly allocated arena, or NULL on a
+ *  failure.
+ */
+struct arena* new_arena(size_t size)
+{
+    struct arena* a = smalloc(sizeof *a);
+    if (a)
+    {
+        if (!size)
+            size=4096;
+        a->head=NULL;
+        a->block=ROUND(size);
+        a->last=NULL;
+    }
+    return a;
+}
+
+/** Deletes safely an arena.
+ *  This function frees an arena created with new_arena, and every
+ *  memory allocated from it: the rtrn structures returned by a parse
+ *  using the arena and the values it gave to option structures must no
+ *  longer be used. The pointer is assigned to NULL. If NULL is passed
+ *  as pointer, no action is performed.
+ *  @param[in,out] ptr The address of the pointer to the arena.
+ */
+void delete_arena(struct arena** ptr)
+{
+    if (*ptr)
+    {
+        struct arblock* b = (*ptr)->head;
+        while (b)
+        {
+            struct arblock* next = b->next;
+            sfree(b);
+            b=next;
+        }
+        sfree(*ptr);
+        *ptr=NULL;
+    }
+}
+
+void* arena_alloc(struct arena* a, size_t size)
+{
+    char* ret=NULL;
+    struct arblock* b = a->head;
+    size=ROUND(size);
+    if (!b || b->size - b->used < size)
+    {
+        size_t bsize = a->block;
+        if (bsize < size)
+            bsize=size;
+        b = smalloc(ROUND(sizeof *b) + bsize);
+        if (b)
+        {
+            b->next=a->head;
+            b->size=bsize;
+            b->used=0;
+            a->head=b;
+            a->block *= 2;
+        }
+    }
+    if (b)
+    {
+        ret = DATA(b) + b->used;
+        b->used += size;
+        a->last=ret;
+    }
+    return ret;
+}
+
+/** Empties an arena for a new use.
+ *  Everything allocated from the arena is lost, but its last block,
+ *  which is the largest one, is kept to serve the next allocations.
+ */
+void arena_reset(struct arena* a)
+{
+    struct arblock* b = a->head;
+    if (b)
+    {
+        struct arblock* old = b->next;
+        while (old)
+        {
+            struct arblock* next = old->next;
+            sfree(old);
+            old=next;
+        }
+        b->next=NULL;
+        b->used=0;
+    }
+    a->last=NULL;
+}
+
+/** Resizes a piece of memory taken from an arena.
+ *  The last piece allocated is extended in place while its block has
+ *  room enough; any other one is copied to a new piece, the old one
+ *  being lost until the arena is deleted.
+ */
+void* arena_realloc(struct arena* a, void* ptr, size_t old, size_t size)
+{
+    char* ret;
+    struct arblock* b = a->head;
+    if (ptr && ptr == a->last && (size_t) ((char*) ptr - DATA(b)) + ROUND(size) <= b->size)
+    {
+        b->used = (char*) ptr - DATA(b) + ROUND(size);
+        ret=ptr;
+    }
+    else
+    {
+        ret = arena_alloc(a, size);
+        if (ret && ptr)
+            memcpy(ret, ptr, old < size ? old : size);
+    }
+    return ret;
+}
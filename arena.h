@@ -0,0 +1,33 @@
+/*
+ *  Libstropt: an easy to use library about command-line options parsing
+ *  Copyright (C) 2010 Paul Bazin
+ *
+ *  This file is part of Libstrotp.
+ *
+ *  This libray is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ *  @file
+ *  Arena internals.
+ *  Allocation functions working on the arenas created by new_arena().
+ *  They are not part of the API.
+ */
+
+#ifndef H_ARENA
+#define H_ARENA
+void* arena_alloc(struct arena*, size_t);
+void* arena_realloc(struct arena*, void*, size_t, size_t);
+void arena_reset(struct arena*);
+#endif /* H_ARENA */
@@ -27,158 +27,274 @@
  *  functions are used by atropt to perform the %option parsing.
  */
 
+#define _POSIX_C_SOURCE 200112L
+#include <time.h>
 #include "stropt.h"
+#include "index.h"
+#include "arena.h"
+#include "respfile.h"
+#include "value.h"
+#include "result.h"
+#include "scan.h"
+#include "store.h"
+#include "command.h"
 #include "atropt.h"
 
-/* Begin debug functions */
-
 void* smalloc(size_t);
 void* srealloc(void*, size_t);
+void sfree(void*);
+
+extern char** environ;
 
-void* smalloc(size_t size)
+static void count_alloc(struct atrstats* stats, char re, size_t size)
 {
-    void* ret;
-    if(rand()%999999)
-        ret=malloc(size);
-    else
-        ret=NULL;
-    return ret;
+    if (stats)
+    {
+        if (re)
+            stats->reallocs++;
+        else
+            stats->allocs++;
+        stats->bytes+=size;
+    }
 }
 
-void* srealloc(void* ptr, size_t size)
+static void stamp(struct atrtime* t)
 {
-    void* ret;
-    if(rand()%999999)
-        ret=realloc(ptr,size);
-    else
-        ret=NULL;
-    return ret;
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    t->sec=ts.tv_sec;
+    t->nsec=ts.tv_nsec;
 }
 
-/* End debug functions */
-
-static int str2cnt(const char* s1, const char* s2)
+static void* ralloc(struct arena* arena, size_t size, struct atrstats* stats)
 {
-    int i=0;
-    while (s1[i]==s2[i] && s1[i]!='\0')
-        i++;
-    if (s1[i] != s2[i])
-        i=0;
-    return i;
+    count_alloc(stats, 0, size);
+    if (arena)
+        return arena_alloc(arena, size);
+    return smalloc(size);
 }
 
-static int deleq(char* str)
+static void* rrealloc(struct arena* arena, void* ptr, size_t old, size_t size, struct atrstats* stats)
 {
-    int i=-1;
-    while (str[++i] != '\0')
-        if (str[i] == '=')
-        {
-            str[i]='\0';
-            return i;
-        }
-    return -1;
+    count_alloc(stats, 1, size);
+    if (arena)
+        return arena_realloc(arena, ptr, old, size);
+    return srealloc(ptr, size);
 }
 
-static struct rtrn* new_return(void)
+static struct rtrn* new_return(size_t hint, struct arena* arena, char withpos, char withhint, struct atrstats* stats)
 {
-    struct rtrn* ret = smalloc(sizeof *ret);
+    struct rtrn* ret = ralloc(arena, sizeof *ret, stats);
     if (ret)
     {
+        if (!hint)
+            hint=1;
         ret->argsc=0;
         ret->errsc=0;
-        ret->argsv = smalloc(sizeof *ret->argsv);
-        ret->errsv = smalloc(sizeof *ret->errsv);
-        ret->errsarg = smalloc(sizeof *ret->errsarg);
-        if (ret->argsv && ret->errsv && ret->errsarg)
+        ret->argscap=hint;
+        ret->errscap=1;
+        ret->arena=arena;
+        ret->arena_owned=0;
+        ret->argspos=NULL;
+        ret->errspos=NULL;
+        ret->files=NULL;
+        ret->errshint=NULL;
+        ret->prev_files=NULL;
+        ret->argsv = ralloc(arena, (sizeof *ret->argsv)*ret->argscap, stats);
+        ret->errsv = ralloc(arena, (sizeof *ret->errsv)*ret->errscap, stats);
+        ret->errsarg = ralloc(arena, (sizeof *ret->errsarg)*ret->errscap, stats);
+        if (withpos)
+        {
+            ret->argspos = ralloc(arena, (sizeof *ret->argspos)*ret->argscap, stats);
+            ret->errspos = ralloc(arena, (sizeof *ret->errspos)*ret->errscap, stats);
+        }
+        if (withhint)
+            ret->errshint = ralloc(arena, (sizeof *ret->errshint)*ret->errscap, stats);
+        if (ret->argsv && ret->errsv && ret->errsarg && (!withpos || (ret->argspos && ret->errspos)) && (!withhint || ret->errshint))
         {
             ret->argsv[0]=NULL;
             ret->errsv[0]=NULL;
             ret->errsarg[0]=0;
         }
+        else if (arena)
+            ret=NULL;
         else
         {
-            free(ret->argsv);
-            free(ret->errsv);
-            free(ret->errsarg);
-            free(ret);
+            sfree(ret->argsv);
+            sfree(ret->errsv);
+            sfree(ret->errsarg);
+            sfree(ret->argspos);
+            sfree(ret->errspos);
+            sfree(ret->errshint);
+            sfree(ret);
             ret=NULL;
         }
     }
     return ret;
 }
 
-static int new_return_arg(struct rtrn** ret, char* arg)
+/* Empties a rtrn structure of a previous parse, keeping its arrays, and
+ * adds the ones this parse needs. The files of the previous parse stay
+ * mapped until the values borrowed from them are compared with the new
+ * ones. */
+static int reuse_return(struct rtrn* ret, char withpos, char withhint, struct atrstats* stats)
 {
-    int r=-1;
-    int i=0;
-    char** tmp;
-    while ((*ret)->argsv[i++]);
-    tmp = srealloc((*ret)->argsv, (sizeof *(*ret)->argsv)*(i+1));
-    if (tmp)
+    close_respfiles(ret->prev_files);
+    ret->prev_files=ret->files;
+    ret->files=NULL;
+    ret->argsc=0;
+    ret->errsc=0;
+    ret->argsv[0]=NULL;
+    ret->errsv[0]=NULL;
+    ret->errsarg[0]=0;
+    if (withpos && !ret->argspos)
+        ret->argspos = ralloc(NULL, (sizeof *ret->argspos)*ret->argscap, stats);
+    if (withpos && !ret->errspos)
+        ret->errspos = ralloc(NULL, (sizeof *ret->errspos)*ret->errscap, stats);
+    if (withhint && !ret->errshint)
+        ret->errshint = ralloc(NULL, (sizeof *ret->errshint)*ret->errscap, stats);
+    if ((withpos && (!ret->argspos || !ret->errspos)) || (withhint && !ret->errshint))
+        return -1;
+    return 0;
+}
+
+static void* grow(struct rtrn* ret, void* array, size_t size, size_t cap, struct atrstats* stats)
+{
+    return rrealloc(ret->arena, array, size*cap, size*2*cap, stats);
+}
+
+static int new_return_arg(struct rtrn** ret, const char* arg, const struct argpos* pos, struct atrstats* stats)
+{
+    int r=0;
+    if ((*ret)->argsc+1 >= (*ret)->argscap)
     {
-        r=0;
-        (*ret)->argsv=tmp;
-        (*ret)->argsv[i-1]=arg;
-        (*ret)->argsv[i]=NULL;
-        (*ret)->argsc=i;
+        char** tmp = grow(*ret, (*ret)->argsv, sizeof *tmp, (*ret)->argscap, stats);
+        struct argpos* tmppos=NULL;
+        if (tmp)
+            (*ret)->argsv=tmp;
+        if ((*ret)->argspos)
+        {
+            tmppos = grow(*ret, (*ret)->argspos, sizeof *tmppos, (*ret)->argscap, stats);
+            if (tmppos)
+                (*ret)->argspos=tmppos;
+        }
+        if (tmp && (tmppos || !(*ret)->argspos))
+            (*ret)->argscap *= 2;
+        else
+            r=-1;
+    }
+    if (!r)
+    {
+        if ((*ret)->argspos)
+            (*ret)->argspos[(*ret)->argsc]=*pos;
+        (*ret)->argsv[(*ret)->argsc++]=(char*) arg;
+        (*ret)->argsv[(*ret)->argsc]=NULL;
     }
     return r;
 }
 
-static int new_return_error(struct rtrn** ret, const char* err, int arg)
+static int new_return_error(struct rtrn** ret, const char* err, const struct argpos* pos, const char* hint, struct atrstats* stats)
 {
-    int r=-2;
-    int i=0;
-    const char** tmpv;
-    int* tmparg;
-    while ((*ret)->errsv[i++]);
-    (*ret)->errsc=i;
-    tmpv = srealloc((*ret)->errsv, (sizeof *(*ret)->errsv)*(i+1));
-    if (tmpv)
+    int r=0;
+    if ((*ret)->errsc+1 >= (*ret)->errscap)
     {
-        r++;
-        (*ret)->errsv=tmpv;
-        (*ret)->errsv[i-1]=err;
-        (*ret)->errsv[i]=NULL;
+        const char** tmpv = grow(*ret, (*ret)->errsv, sizeof *tmpv, (*ret)->errscap, stats);
+        int* tmparg = grow(*ret, (*ret)->errsarg, sizeof *tmparg, (*ret)->errscap, stats);
+        struct argpos* tmppos=NULL;
+        const char** tmphint=NULL;
+        if (tmpv)
+            (*ret)->errsv=tmpv;
+        if (tmparg)
+            (*ret)->errsarg=tmparg;
+        if ((*ret)->errspos)
+        {
+            tmppos = grow(*ret, (*ret)->errspos, sizeof *tmppos, (*ret)->errscap, stats);
+            if (tmppos)
+                (*ret)->errspos=tmppos;
+        }
+        if ((*ret)->errshint)
+        {
+            tmphint = grow(*ret, (*ret)->errshint, sizeof *tmphint, (*ret)->errscap, stats);
+            if (tmphint)
+                (*ret)->errshint=tmphint;
+        }
+        if (tmpv && tmparg && (tmppos || !(*ret)->errspos) && (tmphint || !(*ret)->errshint))
+            (*ret)->errscap *= 2;
+        else
+            r=-1;
     }
-    tmparg = srealloc((*ret)->errsarg, (sizeof *(*ret)->errsarg)*i);
-    if (tmparg)
+    if (!r)
     {
-        r++;
-        (*ret)->errsarg=tmparg;
-        (*ret)->errsarg[i-1]=arg;
+        if ((*ret)->errspos)
+            (*ret)->errspos[(*ret)->errsc]=*pos;
+        if ((*ret)->errshint)
+            (*ret)->errshint[(*ret)->errsc]=hint;
+        (*ret)->errsarg[(*ret)->errsc]=pos->argn;
+        (*ret)->errsv[(*ret)->errsc++]=err;
+        (*ret)->errsv[(*ret)->errsc]=NULL;
     }
     return r;
 }
 
-static int give_value(const char* val, struct option* opt)
+static char* copy_value(const char* val, struct arena* arena, struct atrstats* stats)
+{
+    size_t len = strlen(val)+1;
+    char* ret = ralloc(arena, (sizeof *ret) * len, stats);
+    if (ret)
+        memcpy(ret, val, len);
+    return ret;
+}
+
+static int give_option_value(const char* val, const union atrvalue* typed, struct option* opt, struct atrstate* st)
 {
     int r=0;
-    unsigned short i=0;
+    char borrow = opt->borrow || st->borrow;
+    char ext = borrow || st->arena;
     if (opt->takes_value == 1)
     {
-        free(opt->value);
-        opt->value = smalloc((sizeof *opt->value) * (strlen(val)+1));
+        if (!opt->value_ext)
+            sfree(opt->value);
+        if (borrow)
+            opt->value = (char*) val;
+        else
+            opt->value = copy_value(val, st->arena, st->it.stats);
+        opt->value_ext=ext;
         if (opt->value)
-            strcpy(opt->value, val);
+            opt->value_len=strlen(opt->value);
         else
             r=-1;
     }
     else
     {
-        char** tmp;
-        while (opt->valuev[i++]);
-        tmp = srealloc(opt->valuev, (sizeof *opt->valuev)*(i+1));
+        /* The store packs the values it copies; those of an arena are
+         * copied into it beforehand. */
+        if (!borrow && st->arena)
+            val = copy_value(val, st->arena, st->it.stats);
+        if (!val || store_value(opt, val, !ext, st->it.stats))
+            r=-1;
+    }
+    if (!r && opt->value_type != ATR_STRING)
+    {
+        size_t n = opt->takes_value == 1 ? 1 : opt->typedc+1;
+        union atrvalue* tmp=opt->typedv;
+        if (opt->takes_value != 1 && n > opt->values->typedcap)
+        {
+            size_t cap = opt->values->typedcap ? 2*opt->values->typedcap : 4;
+            count_alloc(st->it.stats, 1, (sizeof *tmp)*cap);
+            tmp = srealloc(opt->typedv, (sizeof *tmp)*cap);
+            if (tmp)
+                opt->values->typedcap=cap;
+        }
+        else if (!tmp)
+        {
+            count_alloc(st->it.stats, 1, sizeof *tmp);
+            tmp = srealloc(opt->typedv, sizeof *tmp);
+        }
         if (tmp)
         {
-            opt->valuev=tmp;
-            (opt->valuev)[i-1] = smalloc((sizeof *(opt->valuev)[i-1]) * (strlen(val)+1));
-            if ((opt->valuev)[i-1])
-                strcpy((opt->valuev)[i-1], val);
-            else
-                r=-1;
-            (opt->valuev)[i]=NULL;
-            opt->valuec=i;
+            opt->typedv=tmp;
+            tmp[n-1]=*typed;
+            opt->typedc=n;
         }
         else
             r=-1;
@@ -186,200 +302,933 @@ static int give_value(const char* val, struct option* opt)
     return r;
 }
 
-static int short_activate(const char* next, struct option* opt)
+/* Stores a decoded value of a result slot, in the same arena as its
+ * strings. */
+static int give_result_typed(const union atrvalue* typed, struct optslot* slot, const struct optspec* spec, struct arena* arena, struct atrstats* stats)
+{
+    if (spec->takes_value == 1)
+        slot->typedc=0;
+    if (slot->typedc >= slot->typedcap)
+    {
+        size_t cap = slot->typedcap ? 2*slot->typedcap : spec->takes_value == 1 ? 1 : 4;
+        union atrvalue* tmp;
+        /* Without a capacity, the decoded values are the defaults of
+         * the option structure, copied here. */
+        while (cap <= slot->typedc)
+            cap*=2;
+        count_alloc(stats, 1, (sizeof *tmp)*cap);
+        tmp = arena_realloc(arena, slot->typedv, (sizeof *tmp)*(slot->typedcap ? slot->typedcap : slot->typedc), (sizeof *tmp)*cap);
+        if (!tmp)
+            return -1;
+        slot->typedv=tmp;
+        slot->typedcap=cap;
+    }
+    slot->typedv[slot->typedc++]=*typed;
+    return 0;
+}
+
+static int give_result_value(const char* val, const union atrvalue* typed, struct optslot* slot, const struct optspec* spec, struct atrstate* st)
 {
     int r=0;
-    opt->active=1;
-    if (next)
+    char* v=(char*) val;
+    struct arena* arena=st->arena;
+    if (!arena)
+    {
+        if (!st->res->arena)
+            st->res->arena=new_arena(0);
+        arena=st->res->arena;
+    }
+    if (!arena)
+        return -1;
+    if (!spec->borrow && !st->borrow)
+        v = copy_value(val, arena, st->it.stats);
+    if (!v)
+        r=-1;
+    else if (spec->takes_value == 1)
+    {
+        slot->value=v;
+        slot->value_len=strlen(v);
+    }
+    else
     {
-        if (opt->takes_value)
+        if (slot->valuec+1 >= slot->valuecap)
+        {
+            size_t cap = slot->valuecap ? 2*slot->valuecap : 4;
+            char** tmp;
+            /* Without a capacity, valuev is the one of the option
+             * structure, whose default values are copied here. */
+            while (cap <= slot->valuec+1)
+                cap*=2;
+            count_alloc(st->it.stats, 1, (sizeof *tmp)*cap);
+            tmp = arena_realloc(arena, slot->valuev, (sizeof *tmp)*(slot->valuecap ? slot->valuecap : slot->valuec), (sizeof *tmp)*cap);
+            if (tmp)
+            {
+                slot->valuev=tmp;
+                slot->valuecap=cap;
+            }
+            else
+                r=-1;
+        }
+        if (!r)
         {
-            if (next[0] != '-' && next[0])
-                r=1;
-            else if (!next[1])
-                r=1;
-            if (r)
-                if (give_value(next, opt))
-                    r=-1;
+            slot->valuev[slot->valuec++]=v;
+            slot->valuev[slot->valuec]=NULL;
         }
     }
-    else
-        r=1;
+    if (!r && spec->type != ATR_STRING)
+        r=give_result_typed(typed, slot, spec, arena, st->it.stats);
     return r;
 }
 
-static int long_activate(const char* arg, int eq, struct option* opt)
+static int give_value(const char* val, const union atrvalue* typed, size_t optn, struct atrstate* st)
+{
+    if (st->res)
+        return give_result_value(val, typed, touch_slot(st->res, optn), st->it.idx->spec+optn, st);
+    return give_option_value(val, typed, st->it.idx->optv[optn], st);
+}
+
+static void set_active(size_t optn, char active, char source, struct atrstate* st)
+{
+    if (st->res)
+    {
+        struct optslot* slot=touch_slot(st->res, optn);
+        slot->active=active;
+        slot->source=source;
+    }
+    else
+    {
+        st->it.idx->optv[optn]->active=active;
+        st->it.idx->optv[optn]->source=source;
+    }
+}
+
+static char get_source(size_t optn, const struct atrstate* st)
+{
+    if (st->res)
+        return slot_source(st->res, optn);
+    return st->it.idx->optv[optn]->source;
+}
+
+/* Forgets where the options were set from by a previous parse, so that
+ * the sources of this one take precedence as they should. */
+static void reset_sources(struct atrstate* st)
+{
+    size_t optn;
+    if (st->res)
+        for (optn=0;optn<st->res->touchedc;optn++)
+            st->res->slot[st->res->touchedv[optn]].source=ATR_SRC_DEFAULT;
+    else
+        for (optn=0;optn<st->it.idx->optc;optn++)
+            st->it.idx->optv[optn]->source=ATR_SRC_DEFAULT;
+}
+
+static int layer_error(struct atrstate* st, const char* err, const struct argpos* pos, const char* hint)
 {
+    if (st->it.stats)
+        st->it.stats->errors++;
+    return new_return_error(&st->ret, err, pos, hint, st->it.stats);
+}
+
+/* Applies a setting from a configuration file or from the environment
+ * as --name=value would be, except to the options already set from a
+ * source of higher precedence. */
+static int apply_setting(struct atrstate* st, const char* name, size_t len, const char* value, const struct argpos* pos, char source)
+{
+    const struct optidx* idx=st->it.idx;
+    const struct optname* nm;
+    size_t e;
+    if (st->it.stats)
+    {
+        st->it.stats->long_lookups++;
+        nm=long_lookup(idx, name, len, &st->it.stats->compares);
+    }
+    else
+        nm=long_lookup(idx, name, len, NULL);
+    if (!nm)
+        return layer_error(st, "no option matched", pos, st->it.suggest ? closest(idx, name, len) : NULL);
+    for (e=nm->first;e<nm->first+nm->count;e++)
+    {
+        const struct optent* ent = idx->long_ent + e;
+        const struct optspec* spec = idx->spec + ent->opt;
+        const char* val = ent->act && spec->takes_value ? value : NULL;
+        union atrvalue typed;
+        if (get_source(ent->opt, st) > source)
+            continue;
+        if (val && spec->type != ATR_STRING)
+        {
+            int bad = decode_value(val, spec->type, spec->enumv, &typed);
+            if (bad)
+            {
+                if (layer_error(st, bad == 2 ? "value out of range" : "invalid value", pos, NULL))
+                    return -1;
+                continue;
+            }
+        }
+        set_active(ent->opt, ent->act, source, st);
+        if (val && give_value(val, &typed, ent->opt, st))
+            return -1;
+    }
+    return 0;
+}
+
+/* Applies the variables PREFIX_NAME=value of the environment, NAME
+ * being the long option name in upper case, with '_' for '-'. */
+static int apply_env(struct atrstate* st, const char* prefix)
+{
+    size_t plen=strlen(prefix);
+    char** env;
     int r=0;
-    opt->active=1;
-    if (eq)
+    for (env=environ;!r && *env;env++)
     {
-        if (opt->takes_value)
+        const char* var=*env;
+        const char* p;
+        char name[128];
+        size_t len=0;
+        struct argpos pos;
+        if (strncmp(var, prefix, plen) || var[plen] != '_')
+            continue;
+        for (p=var+plen+1;*p && *p != '=' && len < sizeof name;p++)
         {
-            r = give_value(arg+eq, opt);
+            if (*p == '_')
+                name[len++]='-';
+            else if (*p >= 'A' && *p <= 'Z')
+                name[len++]=*p-'A'+'a';
+            else
+                name[len++]=*p;
         }
+        pos.argn=-1;
+        pos.file=var;
+        pos.offset=0;
+        if (*p == '=')
+            r=apply_setting(st, name, len, p+1, &pos, ATR_SRC_ENV);
+        else
+            r=layer_error(st, "no option matched", &pos, NULL);
     }
     return r;
 }
 
-static int atrshortopt(char last, const char** argv, int argn, char charopt, struct option** optv, struct rtrn** ret)
+/* Applies the settings of a configuration file, which stays mapped as
+ * long as the rtrn structure, as response files do. */
+static int apply_file(struct atrstate* st, const char* name)
 {
-    int r=1;
-    char yet=0;
-    unsigned short optn;
-    for (optn=0;optv[optn];optn++)
+    struct respfile* f=open_respfile(name);
+    const char* key;
+    const char* value;
+    size_t len;
+    int status;
+    struct argpos pos;
+    pos.argn=-1;
+    pos.file=name;
+    pos.offset=0;
+    if (!f)
+        return layer_error(st, "cannot read config file", &pos, NULL);
+    f->next=st->ret->files;
+    st->ret->files=f;
+    while ((status = respfile_line(f, &key, &len, &value, &pos.offset)) == 1)
+        if (apply_setting(st, key, len, value, &pos, ATR_SRC_FILE))
+            return -1;
+    return status;
+}
+
+static int open_response(struct atrit* it, const char* name, const struct argpos* pos)
+{
+    struct respfile* f=NULL;
+    if (it->depth >= it->maxdepth)
+        it->err="response files nested too deeply";
+    else
     {
-        short shn;
-        for (shn=0;optv[optn]->short_act[shn];shn++)
-            if (optv[optn]->short_act[shn] == charopt)
+        f=open_respfile(name);
+        it->err="cannot read response file";
+    }
+    if (!f)
+    {
+        it->errpos=*pos;
+        return 2;
+    }
+    f->argn=pos->argn;
+    f->up=it->top;
+    f->next=it->files;
+    it->files=f;
+    it->top=f;
+    it->depth++;
+    return 0;
+}
+
+/* Gives in *ptok the next token to parse, without consuming it: the
+ * next argument, or the next token of the response file being read. An
+ * '@' argument is replaced by the tokens of its file. Returns 1 if a
+ * token is given, 0 at the end, 2 if a response file cannot be read,
+ * the error being in it->err, and -1 if an internal error occurs. */
+static int peek_token(struct atrit* it, const char** ptok)
+{
+    while (!it->tok)
+    {
+        const char* tok;
+        struct argpos pos;
+        if (it->failed)
+            return -1;
+        if (it->top)
+        {
+            int status = respfile_token(it->top, &tok, &pos.offset);
+            if (status == -1)
+                it->failed=1;
+            if (status != 1)
             {
-                const char* next;
-                int status;
-                yet=1;
-                if (last)
-                    next = (const char*) argv[argn+1];
+                it->top = it->top->up;
+                it->depth--;
+                continue;
+            }
+            pos.argn=it->top->argn;
+            pos.file=it->top->name;
+        }
+        else if (it->argn < it->argc)
+        {
+            tok=it->argv[it->argn];
+            pos.argn=it->argn++;
+            pos.file=NULL;
+            pos.offset=0;
+        }
+        else
+            return 0;
+        if (tok[0] == '@' && tok[1] && it->maxdepth && !it->skip)
+        {
+            if (open_response(it, tok+1, &pos))
+                return 2;
+        }
+        else
+        {
+            it->tok=tok;
+            it->tokpos=pos;
+        }
+    }
+    *ptok=it->tok;
+    return 1;
+}
+
+/* Works as peek_token, but consumes the token, its position being
+ * given by it->pos. */
+static int next_token(struct atrit* it, const char** ptok)
+{
+    int status = peek_token(it, ptok);
+    if (status == 1)
+    {
+        it->pos=it->tokpos;
+        it->tok=NULL;
+        if (it->stats)
+            it->stats->args++;
+        if (it->hooks && it->hooks->arg)
+        {
+            struct atrtime t;
+            stamp(&t);
+            it->hooks->arg(it->hooks->ctx, *ptok, &it->pos, &t);
+        }
+    }
+    return status;
+}
+
+static int error_event(struct atrit* it, struct atrevent* ev, const char* err, const struct argpos* pos)
+{
+    if (it->stats)
+        it->stats->errors++;
+    ev->type=ATR_ERROR;
+    ev->opt=0;
+    ev->value=NULL;
+    ev->value_len=0;
+    ev->error=err;
+    ev->pos=*pos;
+    ev->hint=NULL;
+    return 1;
+}
+
+/* Gives the event of the current entry of a short or long option. */
+static int entry_event(struct atrit* it, struct atrevent* ev)
+{
+    const struct optent* ent;
+    if (it->is_long)
+        ent = it->idx->long_ent + it->entn;
+    else
+        ent = it->idx->short_ent + it->entn;
+    ev->opt=ent->opt;
+    ev->value=NULL;
+    ev->error=NULL;
+    if (!ent->act)
+        ev->type=ATR_UNACTIVATED;
+    else
+    {
+        const struct optspec* spec = it->idx->spec + ent->opt;
+        char takes_value = spec->takes_value;
+        ev->type=ATR_ACTIVATED;
+        if (it->is_long)
+        {
+            if (it->eq != -1 && takes_value)
+                ev->value = it->arg+2+it->eq+1;
+        }
+        else if (!it->arg[it->s_flag+1])
+        {
+            /* The last option of a cluster may take the next token as
+             * its value; if it does not, the token is skipped. */
+            const char* next;
+            int status = peek_token(it, &next);
+            if (status == 2)
+                return error_event(it, ev, it->err, &it->errpos);
+            if (status == -1)
+                return -1;
+            if (status == 1)
+            {
+                if (takes_value && ((next[0] != '-' && next[0]) || (next[0] == '-' && !next[1])))
+                    ev->value=next;
                 else
-                    next = NULL;
-                status = short_activate(next, optv[optn]);
-                if (!status)
-                    r=0;
-                else if (status == -1)
-                    r=-1;
-                break;
+                    it->jump=1;
             }
-        if (r == -1)
-            break;
-        for (shn=0;optv[optn]->short_unact[shn];shn++)
-            if (optv[optn]->short_unact[shn] == charopt)
+        }
+        if (ev->value && spec->type != ATR_STRING)
+        {
+            int bad = decode_value(ev->value, spec->type, spec->enumv, &ev->typed);
+            if (bad)
             {
-                yet=1;
-                optv[optn]->active=0;
-                break;
+                it->entn++;
+                return error_event(it, ev, bad == 2 ? "value out of range" : "invalid value",
+                                   it->is_long ? &it->pos : &it->tokpos);
             }
+        }
     }
-    if (!yet)
-        if (new_return_error(ret, "no option matched", argn))
-            r=-1;
-    return r;
+    ev->value_len = ev->value ? strlen(ev->value) : 0;
+    ev->pos=it->pos;
+    it->entn++;
+    return 1;
 }
 
-static int atrlongopt(char** argv, int argn, struct option** optv, struct rtrn** ret)
+/* Starts parsing a long option, giving an error event if it matches no
+ * option. */
+static int long_event(struct atrit* it, const char* arg, struct atrevent* ev)
 {
-    int r=0;
-    unsigned short optn;
-    char ok=1;
-    char yet=0;
-    int eq=deleq(argv[argn]+2);
+    const char* name=arg+2;
+    const char* end=scan_eq(name);
+    size_t len=end-name;
+    int eq = *end ? (int) len : -1;
+    const struct optname* nm;
     if (!eq)
     {
-        r=1;
-        if (new_return_error(ret, "illegal '='", argn))
-            r=-1;
+        it->nomatch=1;
+        return error_event(it, ev, "illegal '='", &it->pos);
+    }
+    if (it->stats)
+    {
+        it->stats->long_lookups++;
+        nm=long_lookup(it->idx, name, len, &it->stats->compares);
     }
     else
+        nm=long_lookup(it->idx, name, len, NULL);
+    if (!nm)
     {
-        for (optn=0;optv[optn]&&ok;optn++)
+        error_event(it, ev, "no option matched", &it->pos);
+        if (it->suggest)
+            ev->hint=closest(it->idx, name, len);
+        return 1;
+    }
+    it->arg=arg;
+    it->is_long=1;
+    it->eq=eq;
+    it->entn=nm->first;
+    it->entend=nm->first+nm->count;
+    return 0;
+}
+
+/** Starts iterating over the events of a parse.
+ *  An iterator parses the arguments lazily, giving one event at a time
+ *  through next_event: an option activated, with the value it takes if
+ *  any; an option unactivated; a positional argument; or an error. The
+ *  events are exactly what atropt_result would apply, in the same
+ *  order, but nothing is stored: the iterator needs no memory but its
+ *  own structure, whatever the number of arguments. The options are
+ *  given by their number in the table the index was built from; the
+ *  values and positional arguments point into argv, and into the
+ *  response files if any, which stay mapped until end_iterator.
+ *  @param[out] it The iterator to initialize.
+ *  @param[in] argc The number of arguments, as passed to main.
+ *  @param[in] argv The arguments, as passed to main.
+ *  @param[in] idx An index built with new_option_index.
+ *  @param[in] conf A configuration structure, or NULL. Only its
+ *  respfile_depth, stats, hooks and suggest members are used.
+ */
+void init_iterator(struct atrit* it, int argc, const char* const* argv, const struct optidx* idx, const struct atrconf* conf)
+{
+    it->idx=idx;
+    it->argv=argv;
+    it->argc=argc;
+    it->argn=1;
+    it->skip=0;
+    it->failed=0;
+    it->tok=NULL;
+    it->top=NULL;
+    it->files=NULL;
+    it->depth=0;
+    it->maxdepth = conf ? conf->respfile_depth : 0;
+    it->err=NULL;
+    it->arg=NULL;
+    it->is_long=0;
+    it->s_flag=0;
+    it->entn=0;
+    it->entend=0;
+    it->jump=0;
+    it->eq=-1;
+    it->nomatch=0;
+    it->stats = conf ? conf->stats : NULL;
+    it->hooks = conf ? conf->hooks : NULL;
+    it->ended=0;
+    it->suggest = conf && conf->suggest;
+    it->hint=NULL;
+    it->hint_arg=NULL;
+    if (it->stats)
+        memset(it->stats, 0, sizeof *it->stats);
+    if (it->hooks && it->hooks->begin)
+    {
+        struct atrtime t;
+        stamp(&t);
+        it->hooks->begin(it->hooks->ctx, &t);
+    }
+}
+
+/* Gives the long option name closest to the len characters of name, or
+ * NULL if none is close enough. */
+static const char* closest(const struct optidx* idx, const char* name, size_t len)
+{
+    const char* sug;
+    if (suggest_options(idx, name, len, &sug, 1))
+        return sug;
+    return NULL;
+}
+
+/* Gives the long option name closest to the current cluster, which may
+ * be a long option given with a single '-'. It is looked for once per
+ * cluster. */
+static const char* cluster_hint(struct atrit* it)
+{
+    if (it->hint_arg != it->arg)
+    {
+        size_t len = strcspn(it->arg+1, "=");
+        it->hint_arg=it->arg;
+        it->hint = len > 1 ? closest(it->idx, it->arg+1, len) : NULL;
+    }
+    return it->hint;
+}
+
+/* Calls the end hook, once. */
+static void end_parse(struct atrit* it)
+{
+    if (!it->ended)
+    {
+        it->ended=1;
+        if (it->hooks && it->hooks->end)
         {
-            unsigned short lgn=0;
-            while (optv[optn]->long_act[lgn] && ok)
-                if (str2cnt(optv[optn]->long_act[lgn++], (const char*) argv[argn]+2))
-                {
-                    yet=1;
-                    if (long_activate((const char*) argv[argn]+2, eq+1, optv[optn]))
-                        ok=0;
-                }
-            lgn=0;
-            while (optv[optn]->long_unact[lgn] && ok)
-                if (str2cnt(optv[optn]->long_unact[lgn++], (const char*) argv[argn]+2))
-                {
-                    yet=1;
-                    optv[optn]->active=0;
-                }
+            struct atrtime t;
+            stamp(&t);
+            it->hooks->end(it->hooks->ctx, it->stats, &t);
         }
     }
-    if (!ok)
-        r=-1;
-    else
-        if (!yet)
-            if (new_return_error(ret, "no option matched", argn))
-                r=-1;
-    if (eq != -1)
-        (argv[argn]+2)[eq]='=';
-    return r;
 }
 
-struct rtrn* atropt(int argc, char** argv, struct option** optv)
+static int step(struct atrit* it, struct atrevent* ev)
 {
-    char ok=1;
-    char skip=0;
-    unsigned short argn;
-    struct rtrn* ret=new_return();
-    if (ret)
+    for (;;)
     {
-        for (argn=1;argn<argc&&ok;argn++)
+        const char* arg;
+        int status;
+        if (it->nomatch)
+        {
+            it->nomatch=0;
+            return error_event(it, ev, "no option matched", &it->pos);
+        }
+        if (it->entn < it->entend)
+            return entry_event(it, ev);
+        if (it->arg && !it->is_long)
         {
-            if (argv[argn][0]=='-' && argv[argn][1] && !skip)
+            /* The current character of the cluster is done. */
+            unsigned char c = it->arg[++it->s_flag];
+            if (c)
             {
-                if (argv[argn][1] != '-')
-                {
-                    char jump=0;
-                    unsigned short s_flag=0;
-                    while (argv[argn][++s_flag] != '\0')
-                    {
-                        /* Test statements */
-                        char last=0;
-                        int status;
-                        if (!argv[argn][s_flag+1])
-                            last=1;
-                        status = atrshortopt(last, (const char**) argv, argn, argv[argn][s_flag], optv, &ret);
-                        if (status != -1)
-                        {
-                            if (!status)
-                                jump=1;
-                        }
-                        else
-                            ok=0;
-                        /* End test statements */
-
-                        /* short optn;
-                        for (optn=0;optv[optn]!= NULL;optn++)
-                        {
-                            short shn;
-                            for (shn=0;optv[optn]->short_unact[shn]!='\0';shn++)
-                                if (optv[optn]->short_unact[shn] == argv[argn][s_flag])
-                                    optv[optn]->active=0;
-                            for (shn=0;optv[optn]->short_act[shn]!='\0';shn++)
-                                if (optv[optn]->short_act[shn] == argv[argn][s_flag])
-                                {
-                                    optv[optn]->active=1;
-                                    if (optv[optn]->takes_value == 1)
-                                        next=optv[optn];
-                                }
-                        } */
-                    }
-                    if (jump)
-                        argn++;
-                }
-                else
+                if (it->stats)
+                    it->stats->short_lookups++;
+                it->entn = it->idx->short_first[c];
+                it->entend = it->idx->short_first[c+1];
+                if (it->entn == it->entend)
                 {
-                    if (argv[argn][2] == '\0')
-                        skip=1;
-                    else
-                    {
-                        if (atrlongopt(argv, argn, optv, &ret) == -1)
-                            ok=0;
-                    }
+                    error_event(it, ev, "no option matched", &it->pos);
+                    if (it->suggest)
+                        ev->hint=cluster_hint(it);
+                    return 1;
                 }
+                continue;
             }
-            else
+            if (it->jump)
+                next_token(it, &arg);
+        }
+        it->arg=NULL;
+        status = next_token(it, &arg);
+        if (status == 2)
+            return error_event(it, ev, it->err, &it->errpos);
+        if (status != 1)
+            return status;
+        if (arg[0]=='-' && arg[1] && !it->skip)
+        {
+            if (arg[1] != '-')
             {
-                if (new_return_arg(&ret, argv[argn]))
-                    ok=0;
+                it->arg=arg;
+                it->is_long=0;
+                it->s_flag=0;
+                it->jump=0;
             }
+            else if (arg[2] == '\0')
+                it->skip=1;
+            else if (long_event(it, arg, ev))
+                return 1;
+        }
+        else
+        {
+            ev->type=ATR_POSITIONAL;
+            ev->opt=0;
+            ev->value=arg;
+            ev->value_len=strlen(arg);
+            ev->error=NULL;
+            ev->pos=it->pos;
+            return 1;
         }
     }
-    if (!ok)
+}
+
+/** Gives the next event of a parse.
+ *  @param[in,out] it An iterator initialized by init_iterator.
+ *  @param[out] ev The event.
+ *  @return 1 if an event is given, 0 once all the arguments are
+ *  parsed, -1 if an internal error occurs.
+ */
+int next_event(struct atrit* it, struct atrevent* ev)
+{
+    int r = step(it, ev);
+    if (r != 1)
+        end_parse(it);
+    return r;
+}
+
+/** Ends iterating over the events of a parse.
+ *  This function unmaps the response files read by the iterator: the
+ *  values and positional arguments read from them must no longer be
+ *  used.
+ *  @param[in,out] it The iterator.
+ */
+void end_iterator(struct atrit* it)
+{
+    end_parse(it);
+    close_respfiles(it->files);
+    it->files=NULL;
+}
+
+/* Switches the parse to the index of the subcommand a positional
+ * argument names, if it is the first one. */
+static int enter_command(struct atrstate* st, const char* name, char layers)
+{
+    struct atrcmd* cmd;
+    const struct optidx* idx;
+    size_t optn;
+    if (!st->cmdv || st->cmd || st->it.skip)
+        return 0;
+    cmd=find_command(st->cmdv, name);
+    if (!cmd)
+        return 0;
+    idx=command_index(cmd, st->it.idx->optv);
+    if (!idx)
+        return -1;
+    if (layers)
+        for (optn=0;cmd->optv[optn];optn++)
+            cmd->optv[optn]->source=ATR_SRC_DEFAULT;
+    st->cmd=cmd;
+    st->it.idx=idx;
+    return 1;
+}
+
+/* Parses into a new rtrn structure, or into the one of a previous parse
+ * if reuse is not NULL, dispatching to the subcommands of cmdv if it is
+ * not NULL. */
+static struct rtrn* parse(int argc, const char* const* argv, const struct optidx* idx, struct optres* res, const struct atrconf* conf, struct rtrn* reuse, struct atrcmd* cmdv, struct atrcmd** cmd)
+{
+    char ok=1;
+    char own=0;
+    char layers = conf && (conf->config_file || conf->env_prefix);
+    int status=0;
+    struct atrevent ev;
+    struct atrstate st;
+    struct rtrn* ret=NULL;
+    int entered;
+    /* declared_index gives NULL on a failure, and may be passed as is. */
+    if (!idx)
+        return NULL;
+    st.res=res;
+    st.arena=NULL;
+    st.borrow = conf && conf->borrow;
+    st.cmdv=cmdv;
+    st.cmd=NULL;
+    init_iterator(&st.it, argc, argv, idx, conf);
+    if (conf && conf->arena)
+        st.arena=conf->arena;
+    else if (conf && conf->use_arena)
+    {
+        st.arena=new_arena(0);
+        own = st.arena != NULL;
+        ok=own;
+    }
+    if (ok && reuse)
+    {
+        if (!reuse_return(reuse, layers || (conf && conf->respfile_depth > 0), st.it.suggest, st.it.stats))
+            ret=reuse;
+    }
+    else if (ok)
+    {
+        ret=new_return(argc > 0 ? (size_t) argc : 0, st.arena, layers || (conf && conf->respfile_depth > 0), st.it.suggest, st.it.stats);
+        if (!ret && own)
+            delete_arena(&st.arena);
+    }
+    if (ret)
+    {
+        ret->arena_owned=own;
+        st.ret=ret;
+        if (layers)
+            reset_sources(&st);
+        /* The end hook is called once the other sources are applied. */
+        while (ok && (status = step(&st.it, &ev)) == 1)
+            switch (ev.type)
+            {
+                case ATR_ACTIVATED:
+                    set_active(ev.opt, 1, ATR_SRC_ARGV, &st);
+                    if (ev.value && give_value(ev.value, &ev.typed, ev.opt, &st))
+                        ok=0;
+                    break;
+                case ATR_UNACTIVATED:
+                    set_active(ev.opt, 0, ATR_SRC_ARGV, &st);
+                    break;
+                case ATR_POSITIONAL:
+                    entered=enter_command(&st, ev.value, layers);
+                    if (entered == -1 || (!entered && new_return_arg(&st.ret, ev.value, &ev.pos, st.it.stats)))
+                        ok=0;
+                    break;
+                default:
+                    if (new_return_error(&st.ret, ev.error, &ev.pos, ev.hint, st.it.stats))
+                        ok=0;
+            }
+        if (status == -1)
+            ok=0;
+        ret->files=st.it.files;
+        if (ok && conf && conf->env_prefix && apply_env(&st, conf->env_prefix))
+            ok=0;
+        if (ok && conf && conf->config_file && apply_file(&st, conf->config_file))
+            ok=0;
+        if (ok && res)
+            list_changes(res);
+        close_respfiles(ret->prev_files);
+        ret->prev_files=NULL;
+    }
+    end_parse(&st.it);
+    if (cmd)
+        *cmd=st.cmd;
+    /* No rtrn structure is made when the arena cannot be. */
+    if (!ok && !reuse && ret)
         delete_return(&ret);
+    else if (!ok)
+        ret=NULL;
     return ret;
 }
 
+/** Parses the command-line arguments into a result structure.
+ *  This function works as atropt_conf, but leaves the option
+ *  structures untouched: whether each option is active, and the values
+ *  it is given, are written into a result structure created by
+ *  new_option_result for the same index. As the index is only read,
+ *  any number of parses can use it at the same time, each with its own
+ *  result structure. The values are copied into the result structure,
+ *  or into the arena of the configuration if any, unless they are
+ *  borrowed.
+ *
+ *  Once the parse is over, changedv gives the changedc options of the
+ *  result structure whose slot differs from what the previous parse
+ *  left, or from the defaults of its option structure for the first
+ *  parse.
+ *  @param[in] argc The number of arguments, as passed to main.
+ *  @param[in] argv The arguments, as passed to main.
+ *  @param[in] idx An index built with new_option_index, or NULL, as
+ *  declared_index gives on a failure, which makes the parse fail.
+ *  @param[out] res A result structure built for idx, or NULL to update
+ *  the option structures as atropt_conf does.
+ *  @param[in] conf A configuration structure, or NULL.
+ *  @return A pointer to the rtrn structure describing the parse, or
+ *  NULL on a failure.
+ */
+struct rtrn* atropt_result(int argc, const char* const* argv, const struct optidx* idx, struct optres* res, const struct atrconf* conf)
+{
+    return parse(argc, argv, idx, res, conf, NULL, NULL, NULL);
+}
+
+/** Parses again, reusing the structures of a previous parse.
+ *  This function works as atropt_result, but instead of allocating a
+ *  new rtrn structure, it empties the one returned by a previous parse
+ *  and keeps its arrays, which only grow when this parse needs more.
+ *  The result structure, if %any, is emptied by reset_option_result,
+ *  which keeps the memory of its values too: a long-running program
+ *  parsing the same kind of arguments again and again, as a daemon
+ *  reloading its settings, soon allocates nothing more.
+ *
+ *  changedv then lists the options this parse changed, comparing their
+ *  activation and values with the previous parse. The values of the
+ *  previous parse are read for this, so borrowed ones must still be
+ *  valid: the arguments of a parse must be kept until the next one.
+ *  The response and configuration files of the previous parse are
+ *  kept mapped for this, and unmapped once the comparison is done.
+ *  Read the slots through option_slot.
+ *
+ *  The rtrn structure must not come from an arena: neither the arena
+ *  nor the use_arena member of the configuration can be set.
+ *  @param[in,out] ret A rtrn structure returned by atropt_result or
+ *  atropt_conf, not yet deleted. It must still be freed by
+ *  delete_return, even if the parse fails, but is then meaningless.
+ *  @param[in] argc The number of arguments, as passed to main.
+ *  @param[in] argv The arguments, as passed to main.
+ *  @param[in] idx An index built with new_option_index, or NULL,
+ *  which makes the parse fail.
+ *  @param[in,out] res A result structure built for idx, or NULL to
+ *  update the option structures as atropt_conf does.
+ *  @param[in] conf A configuration structure, or NULL.
+ *  @return 0 on success, -1 on a failure.
+ */
+int atropt_reparse(struct rtrn* ret, int argc, const char* const* argv, const struct optidx* idx, struct optres* res, const struct atrconf* conf)
+{
+    if (ret->arena || (conf && (conf->arena || conf->use_arena)))
+        return -1;
+    if (res)
+        reset_option_result(res);
+    return parse(argc, argv, idx, res, conf, ret, NULL, NULL) ? 0 : -1;
+}
+
+/** Parses the command-line arguments of a program made of subcommands.
+ *  This function works as atropt_conf against the global options,
+ *  until a positional argument names one of the subcommands. The rest
+ *  of the arguments is then parsed against the options of this
+ *  subcommand and the global ones, which stay recognized: in "prog
+ *  commit -m msg -v", -v is a global option. Only the table of
+ *  this subcommand is built, calling its build member if its optv
+ *  member is NULL, and compiled, by command_index; the other
+ *  subcommands cost nothing. The subcommand name is not put in argsv,
+ *  nor is a positional argument following "--" taken for one. If an
+ *  option of the subcommand has the same name as a global one, both
+ *  are set.
+ *  @param[in] argc The number of arguments, as passed to main.
+ *  @param[in] argv The arguments, as passed to main.
+ *  @param[in,out] global The declaration of the global options, whose
+ *  index is built by declared_index.
+ *  @param[in,out] cmdv The subcommands, each initialized with
+ *  STATIC_COMMAND, terminated by a subcommand whose name is NULL.
+ *  @param[in] conf A configuration structure, or NULL.
+ *  @param[out] cmd Where to write the address of the subcommand found,
+ *  or NULL if none is named.
+ *  @return A pointer to the rtrn structure describing the parse, or
+ *  NULL on a failure.
+ */
+struct rtrn* atropt_command(int argc, const char* const* argv, struct optdecl* global, struct atrcmd* cmdv, const struct atrconf* conf, struct atrcmd** cmd)
+{
+    const struct optidx* idx=declared_index(global);
+    *cmd=NULL;
+    if (!idx)
+        return NULL;
+    return parse(argc, argv, idx, NULL, conf, NULL, cmdv, cmd);
+}
+
+/** Parses the command-line arguments against an index, as configured.
+ *  This function works as atropt_index, but takes a configuration
+ *  structure to change the way the parse is performed. A configuration
+ *  structure filled with zeros gives the default behaviour, as well as
+ *  passing NULL.
+ *
+ *  The arguments are never written, so they can be read-only, or
+ *  shared by several parses running at the same time. argsv and the
+ *  borrowed values point into them: they are not const only to keep
+ *  the rtrn and option structures unchanged, and must not be written
+ *  through either.
+ *
+ *  If the arena member is set, every memory the parse needs, for the
+ *  rtrn structure as well as for the values given to the option
+ *  structures, is taken from this arena. delete_return then frees
+ *  nothing, and everything is freed by delete_arena. If the use_arena
+ *  member is set instead, the parse creates its own arena, which
+ *  delete_return will delete: the values given by the parse must not
+ *  be used afterwards.
+ *
+ *  If the borrow member is set, the values given to the option
+ *  structures are not copied: value and valuev point into argv, which
+ *  must then stay unchanged as long as the values are used. The same
+ *  happens for each option structure whose borrow member is set.
+ *
+ *  If the respfile_depth member is positive, an argument made of '@'
+ *  followed by a file name is replaced by the tokens of this file,
+ *  split on whitespaces, or on '\0' if the file ends with '\0'. The
+ *  tokens are parsed as if they were given instead of the '@'
+ *  argument, and may name other response files, up to respfile_depth
+ *  files being read at once. The file is mapped in memory rather than
+ *  read, and its tokens are not copied: argsv and the borrowed values
+ *  point into the mapping, which delete_return unmaps. The rtrn
+ *  structure then also has argspos and errspos, giving for each
+ *  argument and error the index of the argument in argv, and the name
+ *  of the response file and the offset in it when it comes from one.
+ *
+ *  If the env_prefix member is set, once the arguments are parsed, each
+ *  environment variable named env_prefix, '_' and an upper case long
+ *  %option name, '-' being written '_', is applied as --name=value
+ *  would be. Then, if the config_file member is set, so is each
+ *  "name=value" line of this file, mapped as response files are. An
+ *  option set by the command line is left alone by the environment and
+ *  the file, and one set by the environment is left alone by the file;
+ *  the source member of the option structure, or of its slot, tells
+ *  which one set it last. The errors in the environment or the file
+ *  have -1 as argument index, and their position names the variable,
+ *  or the file and the offset of the line.
+ *
+ *  If the suggest member is set, the rtrn structure also has errshint,
+ *  giving for each error the long %option name closest to the unknown
+ *  one, as suggest_options finds it, or NULL. A short %option cluster
+ *  of several characters is also compared to the long names, in case
+ *  the user meant a long %option.
+ *  @param[in] argc The number of arguments, as passed to main.
+ *  @param[in] argv The arguments, as passed to main.
+ *  @param[in] idx An index built with new_option_index, or NULL, as
+ *  declared_index gives on a failure, which makes the parse fail.
+ *  @param[in] conf A configuration structure, or NULL.
+ *  @return A pointer to the rtrn structure describing the parse, or
+ *  NULL on a failure.
+ */
+struct rtrn* atropt_conf(int argc, const char* const* argv, const struct optidx* idx, const struct atrconf* conf)
+{
+    return atropt_result(argc, argv, idx, NULL, conf);
+}
+
+/** Parses the command-line arguments against an index.
+ *  This function works as atropt, but uses an index built once with
+ *  new_option_index instead of compiling the table at each call.
+ *  @param[in] argc The number of arguments, as passed to main.
+ *  @param[in] argv The arguments, as passed to main.
+ *  @param[in] idx An index built with new_option_index, or NULL, as
+ *  declared_index gives on a failure, which makes the parse fail.
+ *  @return A pointer to the rtrn structure describing the parse, or
+ *  NULL on a failure.
+ */
+struct rtrn* atropt_index(int argc, char** argv, const struct optidx* idx)
+{
+    return atropt_conf(argc, (const char* const*) argv, idx, NULL);
+}
+
+struct rtrn* atropt(int argc, char** argv, struct option** optv)
+{
+    struct rtrn* ret=NULL;
+    struct optidx* idx=new_option_index(optv);
+    if (idx)
+    {
+        ret=atropt_index(argc, argv, idx);
+        delete_option_index(&idx);
+    }
+    return ret;
+}
@@ -20,14 +20,46 @@
 
 #ifndef H_ATROPT
 #define H_ATROPT
-static int atrshortopt(char, const char**, int, char, struct option**, struct rtrn**);
-static int atrlongopt(char**, int, struct option**, struct rtrn**);
-static int short_activate(const char*, struct option*);
-static int long_activate(const char*, int, struct option*);
-static int str2cnt(const char*, const char*);
-static int deleq(char*);
-static struct rtrn* new_return(void);
-static int new_return_arg(struct rtrn**, char*);
-static int new_return_error(struct rtrn**, const char*, int);
+/* State of a parse applying the events of an iterator. */
+struct atrstate
+{
+    struct atrit it;
+    struct optres* res;
+    struct rtrn* ret;
+    struct arena* arena;
+    char borrow;
+    struct atrcmd* cmdv;
+    struct atrcmd* cmd;
+};
+
+static void count_alloc(struct atrstats*, char, size_t);
+static void stamp(struct atrtime*);
+static void* ralloc(struct arena*, size_t, struct atrstats*);
+static void* rrealloc(struct arena*, void*, size_t, size_t, struct atrstats*);
+static struct rtrn* new_return(size_t, struct arena*, char, char, struct atrstats*);
+static int reuse_return(struct rtrn*, char, char, struct atrstats*);
+static void* grow(struct rtrn*, void*, size_t, size_t, struct atrstats*);
+static int new_return_arg(struct rtrn**, const char*, const struct argpos*, struct atrstats*);
+static int new_return_error(struct rtrn**, const char*, const struct argpos*, const char*, struct atrstats*);
+static int give_value(const char*, const union atrvalue*, size_t, struct atrstate*);
+static void set_active(size_t, char, char, struct atrstate*);
+static char get_source(size_t, const struct atrstate*);
+static void reset_sources(struct atrstate*);
+static int layer_error(struct atrstate*, const char*, const struct argpos*, const char*);
+static int apply_setting(struct atrstate*, const char*, size_t, const char*, const struct argpos*, char);
+static int apply_env(struct atrstate*, const char*);
+static int apply_file(struct atrstate*, const char*);
+static int open_response(struct atrit*, const char*, const struct argpos*);
+static int peek_token(struct atrit*, const char**);
+static int next_token(struct atrit*, const char**);
+static int error_event(struct atrit*, struct atrevent*, const char*, const struct argpos*);
+static int entry_event(struct atrit*, struct atrevent*);
+static int long_event(struct atrit*, const char*, struct atrevent*);
+static const char* closest(const struct optidx*, const char*, size_t);
+static const char* cluster_hint(struct atrit*);
+static void end_parse(struct atrit*);
+static int step(struct atrit*, struct atrevent*);
+static int enter_command(struct atrstate*, const char*, char);
+static struct rtrn* parse(int, const char* const*, const struct optidx*, struct optres*, const struct atrconf*, struct rtrn*, struct atrcmd*, struct atrcmd**);
 #endif /* H_ATROPT */
 
@@ -0,0 +1,246 @@
+/*
+ *  Libstropt: an easy to use library about command-line options parsing
+ *  Copyright (C) 2010 Paul Bazin
+ *
+ *  This file is part of Libstrotp.
+ *
+ *  This libray is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ *  @file
+ *  Batch parsing.
+ *  @author Paul Bazin
+ *  @date 2010
+ *  @version 0.9-a2
+ *
+ *  This file contains atropt_batch, which parses many argument vectors
+ *  against one index on several threads. Each thread owns a range of
+ *  the vectors, parsed from its front; a thread which has finished its
+ *  range steals the back half of the largest range left, so that a few
+ *  long vectors do not keep the other threads waiting.
+ */
+
+#define _POSIX_C_SOURCE 200112L
+#include <pthread.h>
+#include <unistd.h>
+#include "stropt.h"
+
+void* smalloc(size_t);
+void* srealloc(void*, size_t);
+void sfree(void*);
+
+/* Vectors left to a thread: from lo to hi excluded. */
+struct range
+{
+    pthread_mutex_t lock;
+    size_t lo;
+    size_t hi;
+};
+
+struct batch
+{
+    const int* argcv;
+    const char* const* const* argvv;
+    const struct optidx* idx;
+    struct optres** resv;
+    struct rtrn** retv;
+    const struct atrconf* conf;
+    int threads;
+    struct range* rangev;
+};
+
+struct worker
+{
+    struct batch* b;
+    int n;
+};
+
+static void parse_one(struct batch* b, size_t i)
+{
+    b->resv[i] = new_option_result(b->idx);
+    if (b->resv[i])
+    {
+        b->retv[i] = atropt_result(b->argcv[i], b->argvv[i], b->idx, b->resv[i], b->conf);
+        if (!b->retv[i])
+            delete_option_result(b->resv+i);
+    }
+}
+
+/* Gives in *i the next vector the thread n has to parse; returns 0 once
+ * there is none left. */
+static int take(struct batch* b, int n, size_t* i)
+{
+    struct range* own = b->rangev+n;
+    int r=0;
+    pthread_mutex_lock(&own->lock);
+    if (own->lo < own->hi)
+    {
+        *i = own->lo++;
+        r=1;
+    }
+    pthread_mutex_unlock(&own->lock);
+    while (!r)
+    {
+        int victim=-1;
+        size_t most=0;
+        size_t lo=0;
+        size_t hi=0;
+        int v;
+        for (v=0;v<b->threads;v++)
+            if (v != n)
+            {
+                size_t left;
+                pthread_mutex_lock(&b->rangev[v].lock);
+                left = b->rangev[v].hi - b->rangev[v].lo;
+                pthread_mutex_unlock(&b->rangev[v].lock);
+                if (left > most)
+                {
+                    most=left;
+                    victim=v;
+                }
+            }
+        if (victim == -1)
+            break;
+        pthread_mutex_lock(&b->rangev[victim].lock);
+        if (b->rangev[victim].lo < b->rangev[victim].hi)
+        {
+            hi = b->rangev[victim].hi;
+            lo = hi - (hi - b->rangev[victim].lo + 1)/2;
+            b->rangev[victim].hi = lo;
+        }
+        pthread_mutex_unlock(&b->rangev[victim].lock);
+        if (lo < hi)
+        {
+            pthread_mutex_lock(&own->lock);
+            own->lo = lo+1;
+            own->hi = hi;
+            pthread_mutex_unlock(&own->lock);
+            *i=lo;
+            r=1;
+        }
+    }
+    return r;
+}
+
+static void* work(void* data)
+{
+    struct worker* w = data;
+    size_t i;
+    while (take(w->b, w->n, &i))
+        parse_one(w->b, i);
+    return NULL;
+}
+
+/** Parses many argument vectors against one index.
+ *  This function parses each of the n argument vectors as
+ *  atropt_result would, into a new result structure, using a pool of
+ *  threads. The outcome of the i-th vector is given in resv[i] and
+ *  retv[i], whatever the order the vectors were parsed in; you have to
+ *  free each of them with delete_option_result and delete_return. The
+ *  configuration is shared by all the parses, so its arena and stats
+ *  members must be NULL, and its hooks are called from all the threads
+ *  at once. With one thread, the vectors are parsed in order by the
+ *  calling thread itself, which gives a deterministic behaviour, for
+ *  instance for testing.
+ *  @param[in] n The number of argument vectors.
+ *  @param[in] argcv The number of arguments of each vector.
+ *  @param[in] argvv The argument vectors.
+ *  @param[in] idx An index built with new_option_index.
+ *  @param[out] resv An array of n pointers, receiving the result
+ *  structures.
+ *  @param[out] retv An array of n pointers, receiving the rtrn
+ *  structures.
+ *  @param[in] conf A configuration structure, or NULL.
+ *  @param[in] threads The number of threads to use, the calling one
+ *  included; 0 to use one per online processor.
+ *  @return 0 on a success, -1 if any parse failed: its entries in resv
+ *  and retv are then NULL, the others still have to be freed.
+ */
+int atropt_batch(size_t n, const int* argcv, const char* const* const* argvv, const struct optidx* idx, struct optres** resv, struct rtrn** retv, const struct atrconf* conf, int threads)
+{
+    int r=0;
+    size_t i;
+    struct batch b;
+    if (conf && (conf->arena || conf->stats))
+        return -1;
+    for (i=0;i<n;i++)
+    {
+        resv[i]=NULL;
+        retv[i]=NULL;
+    }
+    if (threads < 1)
+    {
+        long online = sysconf(_SC_NPROCESSORS_ONLN);
+        threads = online > 0 ? (int) online : 1;
+    }
+    if ((size_t) threads > n)
+        threads = n ? (int) n : 1;
+    b.argcv=argcv;
+    b.argvv=argvv;
+    b.idx=idx;
+    b.resv=resv;
+    b.retv=retv;
+    b.conf=conf;
+    b.threads=threads;
+    b.rangev=NULL;
+    if (threads > 1)
+        b.rangev = smalloc((sizeof *b.rangev)*threads);
+    if (b.rangev)
+    {
+        pthread_t* tid = smalloc((sizeof *tid)*threads);
+        struct worker* w = smalloc((sizeof *w)*threads);
+        char* started = smalloc((sizeof *started)*threads);
+        int t;
+        for (t=0;t<threads;t++)
+        {
+            pthread_mutex_init(&b.rangev[t].lock, NULL);
+            b.rangev[t].lo = n/threads*t;
+            b.rangev[t].hi = t == threads-1 ? n : n/threads*(t+1);
+        }
+        /* A range left without a thread is stolen by the others, the
+         * calling thread working as the first one. */
+        for (t=1;tid && w && started && t<threads;t++)
+        {
+            w[t].b=&b;
+            w[t].n=t;
+            started[t] = !pthread_create(tid+t, NULL, work, w+t);
+        }
+        if (w)
+        {
+            w[0].b=&b;
+            w[0].n=0;
+            work(w);
+        }
+        else
+            for (i=0;i<n;i++)
+                parse_one(&b, i);
+        for (t=1;tid && w && started && t<threads;t++)
+            if (started[t])
+                pthread_join(tid[t], NULL);
+        for (t=0;t<threads;t++)
+            pthread_mutex_destroy(&b.rangev[t].lock);
+        sfree(started);
+        sfree(w);
+        sfree(tid);
+        sfree(b.rangev);
+    }
+    else
+        for (i=0;i<n;i++)
+            parse_one(&b, i);
+    for (i=0;i<n;i++)
+        if (!retv[i])
+            r=-1;
+    return r;
+}
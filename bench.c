@@ -0,0 +1,820 @@
+/*
+ *  Libstropt: an easy to use library about command-line options parsing
+ *  Copyright (C) 2010 Paul Bazin
+ *
+ *  This file is part of Libstrotp.
+ *
+ *  This libray is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ *  @file
+ *  Benchmark.
+ *  @author Paul Bazin
+ *  @date 2010
+ *  @version 0.9-a2
+ *
+ *  This program builds synthetic option tables, from 10 to 10000
+ *  options, and times against them:
+ *  - building the table, then atropt(), atropt_result() against a
+ *    prebuilt index, glibc's getopt_long() and atropt_getopt_long(),
+ *    checked to return the same, per argument, with the allocations
+ *    and the peak memory of a parse;
+ *  - suggest_options() looking for the names closest to misspelt ones;
+ *  - the startup of a program made of subcommands, whose tables are
+ *    built up front or on demand;
+ *  - the completion of command lines, from a table compiled from the
+ *    index or loaded from its cache file;
+ *  - the parse of an option repeated up to 100000 times;
+ *  - the parse of up to 2 million arguments against 100000 options,
+ *    which must stay linear;
+ *  - the byte scanning kernels.
+ *
+ *  Run it with `make run-bench`.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+#include <stdio.h>
+#include <time.h>
+#include <unistd.h>
+#include "stropt.h"
+#include "stropt_getopt.h"
+#include "bench.h"
+
+#define ARGC 256
+#define SHORTS "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ"
+
+/* Allocator counting the allocations and the bytes in use. */
+union head
+{
+    size_t size;
+    long l;
+    double d;
+    void* p;
+};
+
+static unsigned long allocs;
+static size_t live;
+static size_t peak;
+
+static void* count_alloc(void* ctx, size_t size)
+{
+    union head* h = malloc(sizeof *h + size);
+    (void)ctx;
+    if (!h)
+        return NULL;
+    h->size=size;
+    allocs++;
+    live+=size;
+    if (live > peak)
+        peak=live;
+    return h+1;
+}
+
+static void* count_resize(void* ctx, void* ptr, size_t size)
+{
+    union head* h;
+    size_t old=0;
+    (void)ctx;
+    if (ptr)
+    {
+        h = (union head*)ptr-1;
+        old=h->size;
+    }
+    else
+        h=NULL;
+    h = realloc(h, sizeof *h + size);
+    if (!h)
+        return NULL;
+    h->size=size;
+    allocs++;
+    live+=size-old;
+    if (live > peak)
+        peak=live;
+    return h+1;
+}
+
+static void count_release(void* ctx, void* ptr)
+{
+    union head* h = (union head*)ptr-1;
+    (void)ctx;
+    live-=h->size;
+    free(h);
+}
+
+/* Starts counting: the counters are then relative to the memory in
+ * use at that point. */
+static void count_start(void)
+{
+    allocs=0;
+    peak=live;
+}
+
+static double now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec*1e9 + ts.tv_nsec;
+}
+
+/* Small generator, so that the inputs do not depend on rand(). */
+static unsigned long seed;
+
+static unsigned long next(unsigned long n)
+{
+    seed = seed*1103515245UL + 12345UL;
+    return ((seed >> 16) & 0x7fff) % n;
+}
+
+/* Synthetic option set: names, whether each option takes a value (1 or
+ * 2 for several values) and its short activator if any. */
+struct spec
+{
+    size_t optc;
+    char** names;
+    char** unnames;
+    char* takes_value;
+    char* shorts;
+    char* buf;
+};
+
+static int new_spec(struct spec* s, size_t optc)
+{
+    size_t i;
+    char* p;
+    s->optc=optc;
+    s->names = malloc((sizeof *s->names)*optc);
+    s->unnames = malloc((sizeof *s->unnames)*optc);
+    s->takes_value = malloc(optc);
+    s->shorts = malloc(optc);
+    s->buf = malloc(24*optc);
+    if (!s->names || !s->unnames || !s->takes_value || !s->shorts || !s->buf)
+        return -1;
+    p=s->buf;
+    for (i=0;i<optc;i++)
+    {
+        s->names[i]=p;
+        p += sprintf(p, "opt%lu", (unsigned long)i)+1;
+        s->unnames[i]=NULL;
+        if (i%4 == 3)
+        {
+            s->unnames[i]=p;
+            p += sprintf(p, "no-opt%lu", (unsigned long)i)+1;
+        }
+        s->takes_value[i] = i%3 == 1 ? 1 : i%7 == 2 ? 2 : 0;
+        s->shorts[i] = i < sizeof SHORTS - 1 ? SHORTS[i] : '\0';
+    }
+    return 0;
+}
+
+static void delete_spec(struct spec* s)
+{
+    free(s->names);
+    free(s->unnames);
+    free(s->takes_value);
+    free(s->shorts);
+    free(s->buf);
+}
+
+static struct option** build_table(const struct spec* s)
+{
+    struct option** optv = new_option_table(s->optc);
+    size_t i;
+    if (!optv)
+        return NULL;
+    for (i=0;i<s->optc;i++)
+    {
+        char act[2];
+        int fail=0;
+        act[0]=s->shorts[i];
+        act[1]='\0';
+        optv[i]->takes_value=s->takes_value[i];
+        if (act[0])
+            fail |= set_short_options(optv[i], act, "");
+        fail |= new_long_option(optv[i], 1, s->names[i]);
+        if (s->unnames[i])
+            fail |= new_long_option(optv[i], 0, s->unnames[i]);
+        if (fail)
+        {
+            delete_option_table(&optv);
+            return NULL;
+        }
+    }
+    return optv;
+}
+
+/* Synthetic argument vector: short clusters, long options with or
+ * without values, unactivators, positional and unknown arguments. */
+static char** new_args(const struct spec* s, char* buf)
+{
+    static char* argv[ARGC+2];
+    static char name[] = "bench";
+    size_t shortc = s->optc < sizeof SHORTS - 1 ? s->optc : sizeof SHORTS - 1;
+    int i;
+    argv[0]=name;
+    for (i=1;i<=ARGC;i++)
+    {
+        unsigned long kind = next(10);
+        size_t o = next(s->optc);
+        argv[i]=buf;
+        if (kind < 3)
+        {
+            int k;
+            int n = 1+next(3);
+            *buf++='-';
+            for (k=0;k<n;k++)
+                *buf++=SHORTS[next(shortc)];
+            *buf++='\0';
+        }
+        else if (kind < 6)
+        {
+            if (s->takes_value[o])
+                buf += sprintf(buf, "--%s=v%lu", s->names[o], next(100))+1;
+            else
+                buf += sprintf(buf, "--%s", s->names[o])+1;
+        }
+        else if (kind < 7)
+        {
+            size_t u = o - o%4 + 3;
+            buf += sprintf(buf, "--%s", u < s->optc ? s->unnames[u] : s->names[o])+1;
+        }
+        else if (kind < 9)
+            buf += sprintf(buf, "file%lu", next(1000))+1;
+        else
+            buf += sprintf(buf, "--unknown%lu", next(1000))+1;
+    }
+    argv[ARGC+1]=NULL;
+    return argv;
+}
+
+static void run(size_t optc, int reps)
+{
+    static char buf[ARGC*32];
+    struct spec s;
+    struct option** optv;
+    struct optidx* idx;
+    struct gotable* got;
+    char** argv;
+    double t;
+    double build_ns;
+    unsigned long build_allocs;
+    size_t build_bytes;
+    double ns[5];
+    unsigned long parse_allocs[3];
+    size_t parse_bytes[2];
+    int r;
+    seed=optc;
+    if (new_spec(&s, optc))
+    {
+        fputs("out of memory\n", stderr);
+        exit(EXIT_FAILURE);
+    }
+    argv = new_args(&s, buf);
+
+    count_start();
+    t=now();
+    optv=build_table(&s);
+    build_ns=now()-t;
+    build_allocs=allocs;
+    build_bytes=live;
+    idx=new_option_index(optv);
+    got=new_gotable(optc, (const char* const*)s.names, s.takes_value, s.shorts);
+    if (!optv || !idx || !got)
+    {
+        fputs("out of memory\n", stderr);
+        exit(EXIT_FAILURE);
+    }
+
+    /* atropt() compiles a temporary index at each call. The values
+     * taken by the options of several values pile up from one call to
+     * the next, so the table is rebuilt before each one, out of the
+     * measure. */
+    ns[0]=0;
+    for (r=0;r<reps;r++)
+    {
+        struct rtrn* ret;
+        size_t base=live;
+        if (r)
+        {
+            delete_option_table(&optv);
+            optv=build_table(&s);
+            base=live;
+        }
+        count_start();
+        t=now();
+        ret=atropt(ARGC+1, argv, optv);
+        ns[0]+=now()-t;
+        parse_allocs[0]=allocs;
+        parse_bytes[0]=peak-base;
+        if (!ret)
+        {
+            fputs("out of memory\n", stderr);
+            exit(EXIT_FAILURE);
+        }
+        delete_return(&ret);
+    }
+
+    /* The values left by atropt() would be taken as defaults by the
+     * result slots, which start from a fresh table and its index. */
+    delete_option_index(&idx);
+    delete_option_table(&optv);
+    optv=build_table(&s);
+    idx=new_option_index(optv);
+    if (!optv || !idx)
+    {
+        fputs("out of memory\n", stderr);
+        exit(EXIT_FAILURE);
+    }
+
+    ns[1]=0;
+    for (r=0;r<reps;r++)
+    {
+        struct rtrn* ret;
+        struct optres* res;
+        size_t base=live;
+        count_start();
+        t=now();
+        res=new_option_result(idx);
+        ret=atropt_result(ARGC+1, (const char* const*)argv, idx, res, NULL);
+        ns[1]+=now()-t;
+        parse_allocs[1]=allocs;
+        parse_bytes[1]=peak-base;
+        if (!ret)
+        {
+            fputs("out of memory\n", stderr);
+            exit(EXIT_FAILURE);
+        }
+        delete_return(&ret);
+        delete_option_result(&res);
+    }
+
+    /* A long-running program keeps its structures from one parse to
+     * the next: once they have grown, nothing more is allocated. */
+    {
+        struct optres* res=new_option_result(idx);
+        struct rtrn* ret=res ? atropt_result(ARGC+1, (const char* const*)argv, idx, res, NULL) : NULL;
+        if (!ret)
+        {
+            fputs("out of memory\n", stderr);
+            exit(EXIT_FAILURE);
+        }
+        ns[3]=0;
+        for (r=0;r<reps;r++)
+        {
+            count_start();
+            t=now();
+            if (atropt_reparse(ret, ARGC+1, (const char* const*)argv, idx, res, NULL))
+            {
+                fputs("out of memory\n", stderr);
+                exit(EXIT_FAILURE);
+            }
+            ns[3]+=now()-t;
+            parse_allocs[2]=allocs;
+        }
+        delete_return(&ret);
+        delete_option_result(&res);
+    }
+
+    /* The front end must return what getopt_long returns. */
+    if (gotable_parse(got, ARGC+1, argv, 0) != gotable_parse(got, ARGC+1, argv, 1))
+    {
+        fputs("atropt_getopt_long differs from getopt_long\n", stderr);
+        exit(EXIT_FAILURE);
+    }
+    t=now();
+    for (r=0;r<reps;r++)
+        gotable_parse(got, ARGC+1, argv, 0);
+    ns[2]=now()-t;
+    t=now();
+    for (r=0;r<reps;r++)
+        gotable_parse(got, ARGC+1, argv, 1);
+    ns[4]=now()-t;
+    /* The next table may be allocated at the same address. */
+    clear_getopt_cache();
+
+    printf("%7lu %11.0f %7lu %9lu | %8.1f %6lu %8lu | %8.1f %6lu %8lu | %8.1f %6lu | %8.1f %8.1f\n",
+           (unsigned long)optc, build_ns, build_allocs, (unsigned long)build_bytes,
+           ns[0]/reps/ARGC, parse_allocs[0], (unsigned long)parse_bytes[0],
+           ns[1]/reps/ARGC, parse_allocs[1], (unsigned long)parse_bytes[1],
+           ns[3]/reps/ARGC, parse_allocs[2], ns[2]/reps/ARGC, ns[4]/reps/ARGC);
+
+    delete_gotable(&got);
+    delete_option_index(&idx);
+    delete_option_table(&optv);
+    delete_spec(&s);
+}
+
+/* Times the suggestions for misspelt names, each name of the table
+ * having a character replaced. */
+static void run_suggest(size_t namec, int reps)
+{
+    static const char letters[] = "abcdefghijklmnopqrstuvwxyz-";
+    struct option** optv = new_option_table(namec);
+    char* buf = malloc(17*namec);
+    struct optidx* idx;
+    const char* sugv[4];
+    size_t found=0;
+    size_t i;
+    double t;
+    int r;
+    if (!optv || !buf)
+    {
+        fputs("out of memory\n", stderr);
+        exit(EXIT_FAILURE);
+    }
+    seed=namec;
+    for (i=0;i<namec;i++)
+    {
+        char* name = buf + 17*i;
+        size_t len = 4+next(12);
+        size_t k;
+        for (k=0;k<len;k++)
+            name[k] = letters[next(k && k+1 < len ? 27 : 26)];
+        name[len]='\0';
+        if (new_long_option(optv[i], 1, name))
+        {
+            fputs("out of memory\n", stderr);
+            exit(EXIT_FAILURE);
+        }
+    }
+    idx=new_option_index(optv);
+    if (!idx)
+    {
+        fputs("out of memory\n", stderr);
+        exit(EXIT_FAILURE);
+    }
+    t=now();
+    for (r=0;r<reps;r++)
+    {
+        char typo[17];
+        const char* name = buf + 17*next(namec);
+        size_t len=strlen(name);
+        memcpy(typo, name, len+1);
+        typo[next(len)]='z';
+        found+=suggest_options(idx, typo, len, sugv, 4);
+    }
+    t=now()-t;
+    printf("%7lu %12.2f %10.2f\n", (unsigned long)namec, t/reps/1000, (double)found/reps);
+    delete_option_index(&idx);
+    delete_option_table(&optv);
+    free(buf);
+}
+
+#define CMDC 80
+#define CMD_OPTC 50
+
+static char cmd_names[CMDC][8];
+static char cmd_opt_names[CMDC*CMD_OPTC][12];
+
+/* Builds the table of a subcommand, named cmdN. */
+static struct option** build_command(const char* name)
+{
+    int c=atoi(name+3);
+    struct option** optv=new_option_table(CMD_OPTC);
+    int i;
+    if (optv)
+        for (i=0;i<CMD_OPTC;i++)
+            if (new_long_option(optv[i], 1, cmd_opt_names[c*CMD_OPTC+i]))
+            {
+                delete_option_table(&optv);
+                break;
+            }
+    return optv;
+}
+
+/* Compares building every subcommand table up front, parsing the
+ * arguments against each, with atropt_command, which only builds the
+ * table of the subcommand named. */
+static void run_commands(int reps)
+{
+    static char arg0[] = "tool";
+    static char verbose_arg[] = "-v";
+    static struct option verbose = STATIC_OPTION("v", NULL, NULL, NULL, 0);
+    static struct option* globalv[] = {&verbose, NULL};
+    static struct optdecl global = STATIC_INDEX(globalv);
+    static struct atrcmd cmdv[CMDC+1];
+    char* argv[5];
+    char opt_arg[24];
+    double ns[2]={0, 0};
+    unsigned long cmd_allocs[2]={0, 0};
+    int r;
+    int c;
+    for (c=0;c<CMDC;c++)
+    {
+        int i;
+        sprintf(cmd_names[c], "cmd%d", c);
+        for (i=0;i<CMD_OPTC;i++)
+            sprintf(cmd_opt_names[c*CMD_OPTC+i], "c%d-opt%d", c, i);
+    }
+    sprintf(opt_arg, "--%s", cmd_opt_names[17*CMD_OPTC+3]);
+    argv[0]=arg0;
+    argv[1]=cmd_names[17];
+    argv[2]=opt_arg;
+    argv[3]=verbose_arg;
+    argv[4]=NULL;
+    for (r=0;r<reps;r++)
+    {
+        struct atrcmd* cmd;
+        struct rtrn* ret;
+        double t;
+        for (c=0;c<CMDC;c++)
+        {
+            cmdv[c].name=cmd_names[c];
+            cmdv[c].optv=NULL;
+            cmdv[c].build=build_command;
+            cmdv[c].allv=NULL;
+            cmdv[c].idx=NULL;
+            cmdv[c].built=0;
+        }
+        cmdv[CMDC].name=NULL;
+        count_start();
+        t=now();
+        ret=atropt_command(4, (const char* const*)argv, &global, cmdv, NULL, &cmd);
+        ns[1]+=now()-t;
+        cmd_allocs[1]=allocs;
+        if (!ret || !cmd)
+        {
+            fputs("out of memory\n", stderr);
+            exit(EXIT_FAILURE);
+        }
+        delete_return(&ret);
+        delete_option_table(&cmd->optv);
+        delete_command_indexes(cmdv);
+        delete_option_index(&global.idx);
+    }
+    /* Apart, so that the memory freed does not weigh on the first
+     * allocations of atropt_command. */
+    for (r=0;r<reps;r++)
+    {
+        struct option** tables[CMDC];
+        struct rtrn* ret;
+        double t;
+        count_start();
+        t=now();
+        for (c=0;c<CMDC;c++)
+        {
+            tables[c]=build_command(cmd_names[c]);
+            ret = tables[c] ? atropt(4, argv, tables[c]) : NULL;
+            if (!ret)
+            {
+                fputs("out of memory\n", stderr);
+                exit(EXIT_FAILURE);
+            }
+            delete_return(&ret);
+        }
+        ns[0]+=now()-t;
+        cmd_allocs[0]=allocs;
+        for (c=0;c<CMDC;c++)
+            delete_option_table(tables+c);
+    }
+    printf("%11s %12.0f %10lu\n", "every table", ns[0]/reps, cmd_allocs[0]);
+    printf("%11s %12.0f %10lu\n", "on demand", ns[1]/reps, cmd_allocs[1]);
+}
+
+/* Completes lines cut within a long %option name, or after an %option
+ * expecting a value, first against a table compiled from the index,
+ * then against the table loaded from its cache file. */
+static void run_complete(size_t optc, int reps)
+{
+    char file[] = "/tmp/stropt-bench-XXXXXX";
+    char line[64];
+    struct spec s;
+    struct option** optv;
+    struct optidx* idx;
+    struct atrcomptab* tab[2];
+    double ns[2]={0, 0};
+    double load=0;
+    size_t cands=0;
+    int fd;
+    int k;
+    int r;
+    seed=optc;
+    fd=mkstemp(file);
+    if (fd == -1 || new_spec(&s, optc) || !(optv=build_table(&s)) || !(idx=new_option_index(optv))
+            || !(tab[0]=new_completion_table(idx)) || close(fd) || write_completion_table(tab[0], file))
+    {
+        fputs("out of memory\n", stderr);
+        exit(EXIT_FAILURE);
+    }
+    delete_option_index(&idx);
+    delete_option_table(&optv);
+    for (r=0;r<reps;r++)
+    {
+        double t=now();
+        tab[1]=load_completion_table(file);
+        load+=now()-t;
+        if (!tab[1])
+        {
+            fputs("out of memory\n", stderr);
+            exit(EXIT_FAILURE);
+        }
+        if (r+1 < reps)
+            delete_completion_table(tab+1);
+    }
+    remove(file);
+    for (k=0;k<2;k++)
+    {
+        seed=optc;
+        for (r=0;r<reps;r++)
+        {
+            size_t o=next(s.optc);
+            int len=sprintf(line, "bench -v --%s ", s.names[o]);
+            struct atrcomp* comp;
+            double t;
+            if (!s.takes_value[o])
+                line[len-1-next(strlen(s.names[o]))]='\0';
+            t=now();
+            comp=complete_line(tab[k], line, 1000);
+            ns[k]+=now()-t;
+            if (!comp)
+            {
+                fputs("out of memory\n", stderr);
+                exit(EXIT_FAILURE);
+            }
+            cands+=comp->candc;
+            delete_completion(&comp);
+        }
+        delete_completion_table(tab+k);
+    }
+    printf("%7lu %12.2f %12.2f %12.2f %10.2f\n", (unsigned long)optc, ns[0]/reps/1000, load/reps/1000, ns[1]/reps/1000, (double)cands/reps/2);
+    delete_spec(&s);
+}
+
+/* Parses an option taking several values repeated valuec times, whose
+ * values are packed by the option structure. */
+static void run_repeat(size_t valuec, int reps)
+{
+    static char arg0[] = "bench";
+    char** argv = malloc((sizeof *argv)*(valuec+2));
+    char* buf = malloc(24*valuec);
+    struct option** optv = new_option_table(1);
+    double t=0;
+    size_t i;
+    int r;
+    if (!argv || !buf || !optv || new_long_option(optv[0], 1, "label"))
+    {
+        fputs("out of memory\n", stderr);
+        exit(EXIT_FAILURE);
+    }
+    optv[0]->takes_value=2;
+    argv[0]=arg0;
+    for (i=0;i<valuec;i++)
+    {
+        argv[i+1]=buf+24*i;
+        sprintf(argv[i+1], "--label=v%lu", (unsigned long)i);
+    }
+    argv[valuec+1]=NULL;
+    for (r=0;r<reps;r++)
+    {
+        struct rtrn* ret;
+        double start;
+        delete_option_table(&optv);
+        optv=new_option_table(1);
+        if (!optv || new_long_option(optv[0], 1, "label"))
+        {
+            fputs("out of memory\n", stderr);
+            exit(EXIT_FAILURE);
+        }
+        optv[0]->takes_value=2;
+        count_start();
+        start=now();
+        ret=atropt((int)valuec+1, argv, optv);
+        t+=now()-start;
+        if (!ret || option_value_count(optv[0]) != valuec)
+        {
+            fputs("out of memory\n", stderr);
+            exit(EXIT_FAILURE);
+        }
+        delete_return(&ret);
+    }
+    printf("%7lu %12.1f %10lu\n", (unsigned long)valuec, t/reps/valuec, allocs);
+    delete_option_table(&optv);
+    free(argv);
+    free(buf);
+}
+
+/* Parses argc arguments against optc options, with atropt_index() and
+ * atropt_result(), giving the time per argument and the peak memory
+ * per argument of each. */
+static void run_large(size_t argc, size_t optc)
+{
+    static char arg0[] = "bench";
+    char** argv = malloc((sizeof *argv)*(argc+1));
+    char* buf = malloc(32*argc);
+    struct spec s;
+    struct option** optv;
+    struct optidx* idx;
+    struct optres* res;
+    struct rtrn* ret;
+    double ns[2];
+    size_t bytes[2];
+    size_t base;
+    size_t i;
+    seed=argc;
+    if (!argv || !buf || new_spec(&s, optc) || !(optv=build_table(&s)) || !(idx=new_option_index(optv))
+            || !(res=new_option_result(idx)))
+    {
+        fputs("out of memory\n", stderr);
+        exit(EXIT_FAILURE);
+    }
+    argv[0]=arg0;
+    for (i=1;i<argc;i++)
+    {
+        size_t o=(next(0x8000)*0x8000+next(0x8000))%optc;
+        argv[i]=buf+32*i;
+        if (i%5 == 0)
+            sprintf(argv[i], "file%lu", (unsigned long)i);
+        else if (s.takes_value[o])
+            sprintf(argv[i], "--%s=v%lu", s.names[o], (unsigned long)i);
+        else
+            sprintf(argv[i], "--%s", s.unnames[o] && i%2 ? s.unnames[o] : s.names[o]);
+    }
+    argv[argc]=NULL;
+    base=live;
+    count_start();
+    ns[0]=now();
+    ret=atropt_index((int)argc, argv, idx);
+    ns[0]=now()-ns[0];
+    bytes[0]=peak-base;
+    if (!ret)
+    {
+        fputs("out of memory\n", stderr);
+        exit(EXIT_FAILURE);
+    }
+    delete_return(&ret);
+    base=live;
+    count_start();
+    ns[1]=now();
+    ret=atropt_result((int)argc, (const char* const*)argv, idx, res, NULL);
+    ns[1]=now()-ns[1];
+    bytes[1]=peak-base;
+    if (!ret)
+    {
+        fputs("out of memory\n", stderr);
+        exit(EXIT_FAILURE);
+    }
+    printf("%9lu %7lu | %8.1f %9.1f | %8.1f %9.1f\n", (unsigned long)argc, (unsigned long)optc,
+           ns[0]/argc, (double)bytes[0]/argc, ns[1]/argc, (double)bytes[1]/argc);
+    delete_return(&ret);
+    delete_option_result(&res);
+    delete_option_index(&idx);
+    delete_option_table(&optv);
+    delete_spec(&s);
+    free(argv);
+    free(buf);
+}
+
+int main(void)
+{
+    static const size_t sizes[] = {10, 100, 1000, 10000};
+    struct atralloc counter;
+    size_t i;
+    counter.alloc=count_alloc;
+    counter.resize=count_resize;
+    counter.release=count_release;
+    counter.ctx=NULL;
+    set_allocator(&counter);
+    printf("%d arguments per parse\n\n", ARGC);
+    printf("%7s %27s | %24s | %24s | %15s | %17s\n", "", "table construction", "atropt()", "atropt_result()", "atropt_reparse", "getopt_long ns/arg");
+    printf("%7s %11s %7s %9s | %8s %6s %8s | %8s %6s %8s | %8s %6s | %8s %8s\n",
+           "options", "ns", "allocs", "bytes",
+           "ns/arg", "allocs", "peak", "ns/arg", "allocs", "peak", "ns/arg", "allocs", "glibc", "stropt");
+    for (i=0;i<sizeof sizes/sizeof *sizes;i++)
+        run(sizes[i], sizes[i] >= 10000 ? 20 : 200);
+    printf("\n%7s %12s %10s\n", "names", "us/suggest", "found");
+    for (i=0;i<sizeof sizes/sizeof *sizes;i++)
+        run_suggest(sizes[i], 1000);
+    printf("\n%d subcommands of %d options\n", CMDC, CMD_OPTC);
+    printf("%11s %12s %10s\n", "", "ns/startup", "allocs");
+    run_commands(200);
+    printf("\n%7s %12s %12s %12s %10s\n", "options", "us/complete", "us/load", "us/complete", "candidates");
+    for (i=0;i<sizeof sizes/sizeof *sizes;i++)
+        run_complete(sizes[i], sizes[i] >= 10000 ? 100 : 1000);
+    printf("\n%7s %12s %10s\n", "values", "ns/value", "allocs");
+    for (i=0;i<sizeof sizes/sizeof *sizes;i++)
+        run_repeat(10*sizes[i], sizes[i] >= 1000 ? 10 : 100);
+    printf("\n%9s %7s | %18s | %18s\n", "", "", "atropt_index()", "atropt_result()");
+    printf("%9s %7s | %8s %9s | %8s %9s\n", "arguments", "options", "ns/arg", "bytes/arg", "ns/arg", "bytes/arg");
+    /* The table is the same for every size: the time per argument then
+     * stays flat if the parse is linear in the arguments. A larger
+     * table costs more per argument only through the cache misses of
+     * its lookups. */
+    run_large(125000, 100000);
+    run_large(500000, 100000);
+    run_large(2000000, 100000);
+    set_allocator(NULL);
+    printf("\n");
+    run_scan();
+    return 0;
+}
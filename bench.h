@@ -0,0 +1,45 @@
+/*
+ *  Libstropt: an easy to use library about command-line options parsing
+ *  Copyright (C) 2010 Paul Bazin
+ *
+ *  This file is part of Libstrotp.
+ *
+ *  This libray is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ *  @file
+ *  Benchmark header.
+ *  @author Paul Bazin
+ *  @date 2010
+ *  @version 0.9-a2
+ *
+ *  This file declares the getopt_long() baseline of the benchmark, and
+ *  its counterpart using the getopt_long() front end of Libstropt, and
+ *  the micro-benchmark of the byte scanning kernels.
+ */
+
+#ifndef H_BENCH
+#define H_BENCH
+
+#include <stddef.h>
+
+struct gotable;
+
+struct gotable* new_gotable(size_t,const char* const*,const char*,const char*);
+unsigned long gotable_parse(struct gotable*,int,char**,char);
+void delete_gotable(struct gotable**);
+void run_scan(void);
+
+#endif
@@ -0,0 +1,124 @@
+/*
+ *  Libstropt: an easy to use library about command-line options parsing
+ *  Copyright (C) 2010 Paul Bazin
+ *
+ *  This file is part of Libstrotp.
+ *
+ *  This libray is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ *  @file
+ *  getopt_long() baseline of the benchmark.
+ *  @author Paul Bazin
+ *  @date 2010
+ *  @version 0.9-a2
+ *
+ *  The option structure of getopt.h has the same name as the one of
+ *  Libstropt, so the baseline lives in its own file, together with the
+ *  getopt_long() front end of Libstropt, which takes the same table.
+ */
+
+#define _GNU_SOURCE
+#include <stdlib.h>
+#include <string.h>
+#include <getopt.h>
+#include "stropt_getopt.h"
+#include "bench.h"
+
+struct gotable
+{
+    struct option* longopts;
+    char* shortopts;
+    char** scratch;
+    int scratchc;
+};
+
+struct gotable* new_gotable(size_t optc, const char* const* names, const char* takes_value, const char* shorts)
+{
+    struct gotable* t = malloc(sizeof *t);
+    size_t i;
+    size_t j=0;
+    if (!t)
+        return NULL;
+    t->longopts = malloc((sizeof *t->longopts)*(optc+1));
+    t->shortopts = malloc(3*optc+2);
+    t->scratch=NULL;
+    t->scratchc=0;
+    if (!t->longopts || !t->shortopts)
+    {
+        delete_gotable(&t);
+        return NULL;
+    }
+    for (i=0;i<optc;i++)
+    {
+        t->longopts[i].name=names[i];
+        t->longopts[i].has_arg = takes_value[i] ? optional_argument : no_argument;
+        t->longopts[i].flag=NULL;
+        t->longopts[i].val=0;
+        if (shorts[i])
+        {
+            t->shortopts[j++]=shorts[i];
+            if (takes_value[i])
+                t->shortopts[j++]=':';
+        }
+    }
+    t->shortopts[j]='\0';
+    memset(t->longopts+optc, 0, sizeof *t->longopts);
+    return t;
+}
+
+/* Returns a checksum of what getopt_long, or atropt_getopt_long if
+ * libstropt is set, returned, for both to be compared. */
+unsigned long gotable_parse(struct gotable* t, int argc, char** argv, char libstropt)
+{
+    unsigned long sum=0;
+    int c;
+    int longindex;
+    if (t->scratchc < argc+1)
+    {
+        char** tmp = realloc(t->scratch, (sizeof *tmp)*(argc+1));
+        if (!tmp)
+            return -1;
+        t->scratch=tmp;
+        t->scratchc=argc+1;
+    }
+    memcpy(t->scratch, argv, (sizeof *argv)*(argc+1));
+    opterr=0;
+    optind=0;
+    for (;;)
+    {
+        longindex=-1;
+        if (libstropt)
+            c = atropt_getopt_long(argc, t->scratch, t->shortopts, (const struct atrlongopt*) t->longopts, &longindex);
+        else
+            c = getopt_long(argc, t->scratch, t->shortopts, t->longopts, &longindex);
+        if (c == -1)
+            break;
+        sum = sum*31 + c + 7*longindex + (optarg ? optarg[0] : 0);
+    }
+    return sum*31 + optind;
+}
+
+void delete_gotable(struct gotable** ptr)
+{
+    if (*ptr)
+    {
+        free((*ptr)->longopts);
+        free((*ptr)->shortopts);
+        free((*ptr)->scratch);
+        free(*ptr);
+        *ptr=NULL;
+    }
+}
@@ -0,0 +1,101 @@
+/*
+ *  Libstropt: an easy to use library about command-line options parsing
+ *  Copyright (C) 2010 Paul Bazin
+ *
+ *  This file is part of Libstrotp.
+ *
+ *  This libray is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ *  @file
+ *  Byte scanning micro-benchmark.
+ *  @author Paul Bazin
+ *  @date 2010
+ *  @version 0.9-a2
+ *
+ *  The kernels of scan.c are internal to the library, so they are
+ *  timed apart from the rest of the benchmark, each at every level the
+ *  processor supports, on strings from 8 to 1024 bytes.
+ */
+
+#define _POSIX_C_SOURCE 200112L
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include "scan.h"
+#include "bench.h"
+
+#define SCAN_REPS 200000
+
+static volatile size_t sink;
+
+static double scan_now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec*1e9 + ts.tv_nsec;
+}
+
+/* Times a kernel on strings of len bytes: 0 finds the '=' of
+ * "--key...=value", 1 compares two equal names and 2 checks a string of
+ * short options. */
+static double time_kernel(int kernel, const char* a, const char* b, size_t len)
+{
+    size_t acc=0;
+    double t=scan_now();
+    int r;
+    for (r=0;r<SCAN_REPS;r++)
+    {
+        if (kernel == 0)
+            acc+=(size_t) (scan_eq(a+(r&1))-a);
+        else if (kernel == 1)
+            acc+=(size_t) scan_same(a+(r&1), b+(r&1), len-1);
+        else
+            acc+=scan_graph(b+(r&1), len-1);
+    }
+    sink=acc;
+    return (scan_now()-t)/SCAN_REPS;
+}
+
+void run_scan(void)
+{
+    static const char* const kernels[] = {"'=' search", "name compare", "short check"};
+    static const size_t lens[] = {8, 32, 128, 1024};
+    static char a[1040];
+    static char b[1040];
+    int best=set_scan_level(SCAN_AVX2);
+    int k;
+    size_t i;
+    printf("%12s %7s %9s %9s %9s\n", "ns/call", "bytes", "scalar", "sse2", "avx2");
+    for (k=0;k<3;k++)
+        for (i=0;i<sizeof lens/sizeof *lens;i++)
+        {
+            size_t len=lens[i];
+            int level;
+            memset(a, 'k', len);
+            a[len-2]='=';
+            a[len]='\0';
+            memset(b, 'k', len);
+            b[len]='\0';
+            printf("%12s %7lu", i ? "" : kernels[k], (unsigned long)len);
+            for (level=SCAN_SCALAR;level<=SCAN_AVX2;level++)
+                if (set_scan_level(level) == level)
+                    printf(" %9.2f", time_kernel(k, a, b, len));
+                else
+                    printf(" %9s", "-");
+            printf("\n");
+        }
+    set_scan_level(best);
+}
@@ -0,0 +1,123 @@
+/*
+ *  Libstropt: an easy to use library about command-line options parsing
+ *  Copyright (C) 2010 Paul Bazin
+ *
+ *  This file is part of Libstrotp.
+ *
+ *  This libray is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ *  @file
+ *  Subcommands.
+ *  @author Paul Bazin
+ *  @date 2010
+ *  @version 0.9-a2
+ *
+ *  This file contains the functions building, on demand, the index of
+ *  a subcommand dispatched by atropt_command: only the subcommand
+ *  named on the command line gets its table built and compiled.
+ */
+
+#define _POSIX_C_SOURCE 200112L
+#include <pthread.h>
+#include "stropt.h"
+#include "command.h"
+
+void* smalloc(size_t);
+void* srealloc(void*, size_t);
+void sfree(void*);
+
+/* Gives the command named name, or NULL. */
+struct atrcmd* find_command(struct atrcmd* cmdv, const char* name)
+{
+    for (;cmdv->name;cmdv++)
+        if (!strcmp(cmdv->name, name))
+            return cmdv;
+    return NULL;
+}
+
+/** Gives the index of a subcommand, building it once.
+ *  The first call builds the table of the subcommand calling its build
+ *  member with its name, unless its optv member is already set, so
+ *  that one function can build the tables of several subcommands. It
+ *  then compiles the
+ *  index of its option structures followed by the global ones, so that
+ *  the global options are still recognized after the subcommand name.
+ *  The next calls just return it. The calls may come from several
+ *  threads at once.
+ *  @param[in,out] cmd A subcommand, as given to atropt_command.
+ *  @param[in] global The table of the global options.
+ *  @return The index, or NULL if it cannot be built; a next call then
+ *  tries again.
+ */
+const struct optidx* command_index(struct atrcmd* cmd, struct option** global)
+{
+    static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+    const struct optidx* idx;
+    pthread_mutex_lock(&lock);
+    if (!cmd->optv && cmd->build)
+    {
+        cmd->optv=cmd->build(cmd->name);
+        cmd->built = cmd->optv != NULL;
+    }
+    if (!cmd->idx && cmd->optv)
+    {
+        size_t optc=0;
+        size_t globc=0;
+        while (cmd->optv[optc])
+            optc++;
+        while (global[globc])
+            globc++;
+        cmd->allv = smalloc((sizeof *cmd->allv)*(optc+globc+1));
+        if (cmd->allv)
+        {
+            memcpy(cmd->allv, cmd->optv, (sizeof *cmd->allv)*optc);
+            memcpy(cmd->allv+optc, global, (sizeof *cmd->allv)*(globc+1));
+            cmd->idx=new_option_index(cmd->allv);
+            if (!cmd->idx)
+            {
+                sfree(cmd->allv);
+                cmd->allv=NULL;
+            }
+        }
+    }
+    idx=cmd->idx;
+    pthread_mutex_unlock(&lock);
+    return idx;
+}
+
+/** Frees the indexes built for subcommands.
+ *  This function frees what command_index built for each subcommand of
+ *  the array, which is terminated by a subcommand whose name is NULL.
+ *  The tables of the subcommands are left alone: those their build
+ *  member returned are yours to free before the call, as their optv
+ *  member is then reset to NULL for them to be built anew. The indexes
+ *  are built again if the subcommands are used anew.
+ *  @param[in,out] cmdv The array of subcommands.
+ */
+void delete_command_indexes(struct atrcmd* cmdv)
+{
+    for (;cmdv->name;cmdv++)
+    {
+        delete_option_index(&cmdv->idx);
+        sfree(cmdv->allv);
+        cmdv->allv=NULL;
+        if (cmdv->built)
+        {
+            cmdv->optv=NULL;
+            cmdv->built=0;
+        }
+    }
+}
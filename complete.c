@@ -0,0 +1,485 @@
+/*
+ *  Libstropt: an easy to use library about command-line options parsing
+ *  Copyright (C) 2010 Paul Bazin
+ *
+ *  This file is part of Libstrotp.
+ *
+ *  This libray is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ *  @file
+ *  Shell completion.
+ *  @author Paul Bazin
+ *  @date 2010
+ *  @version 0.9-a2
+ *
+ *  This file contains the completion tables, which list the words a
+ *  command line can hold, sorted so that the words beginning with what
+ *  the user typed are found by a binary search, and complete_line,
+ *  which completes a command line against them. A table is compiled
+ *  from an index, or loaded from the cache file another run wrote.
+ */
+
+#include <stdio.h>
+#include "stropt.h"
+#include "index.h"
+#include "respfile.h"
+
+void* smalloc(size_t);
+void* srealloc(void*, size_t);
+void sfree(void*);
+
+/* First word of a cache file. */
+#define MAGIC "stropt-completion-1"
+
+/* The words are "-c" and "--name" for the options taking no value, "-c="
+ * and "--name=" for those taking one, and "-c=value" and "--name=value"
+ * for the values of an enumeration. They live in buf when compiled from
+ * an index, and in file when loaded. */
+struct atrcomptab
+{
+    size_t wordc;
+    const char** wordv;
+    char* buf;
+    struct respfile* file;
+};
+
+/* Where option_words writes, or NULL members to only count. */
+struct wordout
+{
+    char* buf;
+    const char** wordv;
+    size_t wordc;
+    size_t size;
+};
+
+static int cmp_word(const void* a, const void* b)
+{
+    return strcmp(*(const char* const*) a, *(const char* const*) b);
+}
+
+static void add_word(struct wordout* out, const char* dash, const char* name, size_t len, const char* value)
+{
+    size_t dlen=strlen(dash);
+    size_t vlen = value ? strlen(value)+1 : 0;
+    if (out->buf)
+    {
+        char* w = out->buf + out->size;
+        memcpy(w, dash, dlen);
+        memcpy(w+dlen, name, len);
+        if (value)
+        {
+            w[dlen+len]='=';
+            memcpy(w+dlen+len+1, value, vlen-1);
+        }
+        w[dlen+len+vlen]='\0';
+        out->wordv[out->wordc]=w;
+    }
+    out->wordc++;
+    out->size += dlen+len+vlen+1;
+}
+
+/* Adds the words of the option reached by the entries ent[0] to ent[n]
+ * excluded: only an activator takes a value. */
+static void option_words(const struct optidx* idx, const struct optent* ent, size_t n, const char* dash, const char* name, size_t len, struct wordout* out)
+{
+    size_t k;
+    for (k=0;k<n;k++)
+        if (ent[k].act && idx->spec[ent[k].opt].takes_value)
+        {
+            const char* const* enumv = idx->spec[ent[k].opt].type == ATR_ENUM ? idx->spec[ent[k].opt].enumv : NULL;
+            add_word(out, dash, name, len, "");
+            for (;enumv && *enumv;enumv++)
+                add_word(out, dash, name, len, *enumv);
+            return;
+        }
+    add_word(out, dash, name, len, NULL);
+}
+
+static void index_words(const struct optidx* idx, struct wordout* out)
+{
+    size_t n;
+    int c;
+    for (c=1;c<=UCHAR_MAX;c++)
+        if (idx->short_first[c] < idx->short_first[c+1])
+        {
+            char name=(char) c;
+            option_words(idx, idx->short_ent+idx->short_first[c], idx->short_first[c+1]-idx->short_first[c], "-", &name, 1, out);
+        }
+    for (n=0;n<idx->long_namec;n++)
+    {
+        const struct optname* nm=idx->long_name+n;
+        option_words(idx, idx->long_ent+nm->first, nm->count, "--", nm->name, nm->len, out);
+    }
+}
+
+/** Compiles the completion table of an index.
+ *  The table lists, sorted, every short and long %option of the index,
+ *  whether it takes a value, and the values of an enumeration, so that
+ *  complete_line finds the ones beginning with what the user typed by
+ *  a binary search. It does not point into the index, which can be
+ *  freed. You have to free the table calling delete_completion_table.
+ *  @param[in] idx An index built with new_option_index.
+ *  @return A pointer to the newly allocated table, or NULL on a
+ *  failure.
+ */
+struct atrcomptab* new_completion_table(const struct optidx* idx)
+{
+    struct wordout out;
+    struct atrcomptab* tab = smalloc(sizeof *tab);
+    if (tab)
+    {
+        out.buf=NULL;
+        out.wordv=NULL;
+        out.wordc=0;
+        out.size=0;
+        index_words(idx, &out);
+        tab->file=NULL;
+        tab->wordc=out.wordc;
+        tab->wordv = smalloc((sizeof *tab->wordv)*(out.wordc+1));
+        tab->buf = smalloc(out.size+1);
+        if (tab->wordv && tab->buf)
+        {
+            out.buf=tab->buf;
+            out.wordv=tab->wordv;
+            out.wordc=0;
+            out.size=0;
+            index_words(idx, &out);
+            qsort(tab->wordv, tab->wordc, sizeof *tab->wordv, cmp_word);
+        }
+        else
+            delete_completion_table(&tab);
+    }
+    return tab;
+}
+
+/** Loads a completion table from a cache file.
+ *  The file, written by write_completion_table, is mapped in memory and
+ *  its words are not copied: loading a table takes much less than
+ *  building the option structures and compiling their index, which
+ *  makes it suitable for a program started at each completion. You
+ *  have to free the table calling delete_completion_table.
+ *  @param[in] file The name of the file.
+ *  @return A pointer to the newly loaded table, or NULL if the file
+ *  cannot be read or was not written by write_completion_table.
+ */
+struct atrcomptab* load_completion_table(const char* file)
+{
+    struct atrcomptab* tab = smalloc(sizeof *tab);
+    if (tab)
+    {
+        size_t cap=0;
+        size_t off;
+        const char* word;
+        int r;
+        char sorted=1;
+        tab->wordc=0;
+        tab->wordv=NULL;
+        tab->buf=NULL;
+        tab->file=open_respfile(file);
+        if (!tab->file || respfile_token(tab->file, &word, &off) != 1 || strcmp(word, MAGIC))
+            r=-1;
+        else
+            while ((r = respfile_token(tab->file, &word, &off)) == 1)
+            {
+                if (tab->wordc+1 >= cap)
+                {
+                    const char** tmp;
+                    cap = cap ? 2*cap : 64;
+                    tmp = srealloc(tab->wordv, (sizeof *tmp)*cap);
+                    if (!tmp)
+                    {
+                        r=-1;
+                        break;
+                    }
+                    tab->wordv=tmp;
+                }
+                if (tab->wordc && strcmp(tab->wordv[tab->wordc-1], word) > 0)
+                    sorted=0;
+                tab->wordv[tab->wordc++]=word;
+            }
+        if (r)
+            delete_completion_table(&tab);
+        else if (!sorted)
+            qsort(tab->wordv, tab->wordc, sizeof *tab->wordv, cmp_word);
+    }
+    return tab;
+}
+
+/** Writes a completion table into a cache file.
+ *  The file holds the words, each one terminated by '\0', which
+ *  load_completion_table reads back as a response file: the values of
+ *  an enumeration may then hold any character, whitespace included.
+ *  It is usually written when the program is installed or first run,
+ *  then loaded at each completion.
+ *  @param[in] tab The table.
+ *  @param[in] file The name of the file, which is replaced.
+ *  @return 0 on success, -1 if the file cannot be written.
+ */
+int write_completion_table(const struct atrcomptab* tab, const char* file)
+{
+    size_t n;
+    int r=0;
+    FILE* f = fopen(file, "w");
+    if (!f)
+        return -1;
+    if (fputs(MAGIC, f) == EOF || fputc('\0', f) == EOF)
+        r=-1;
+    for (n=0;n<tab->wordc && !r;n++)
+        if (fputs(tab->wordv[n], f) == EOF || fputc('\0', f) == EOF)
+            r=-1;
+    if (fclose(f) == EOF)
+        r=-1;
+    return r;
+}
+
+/** Deletes safely a completion table.
+ *  This function frees a table created with new_completion_table or
+ *  load_completion_table, unmapping its file, and assigns the pointer
+ *  to NULL. The completions made from it are left untouched. If NULL
+ *  is passed as pointer, no action is performed.
+ *  @param[in,out] ptr The address of the pointer to the table.
+ */
+void delete_completion_table(struct atrcomptab** ptr)
+{
+    if (*ptr)
+    {
+        sfree((*ptr)->wordv);
+        sfree((*ptr)->buf);
+        close_respfiles((*ptr)->file);
+        sfree(*ptr);
+        *ptr=NULL;
+    }
+}
+
+/* Gives the position of the first word not sorted before the len first
+ * characters of key. */
+static size_t lower_word(const struct atrcomptab* tab, const char* key, size_t len)
+{
+    size_t lo=0;
+    size_t hi=tab->wordc;
+    while (lo < hi)
+    {
+        size_t mid=lo+(hi-lo)/2;
+        if (strncmp(tab->wordv[mid], key, len) < 0)
+            lo=mid+1;
+        else
+            hi=mid;
+    }
+    return lo;
+}
+
+/* Tells whether the word made of the len first characters of key is in
+ * the table. */
+static char has_word(const struct atrcomptab* tab, const char* key, size_t len)
+{
+    size_t n=lower_word(tab, key, len);
+    return n < tab->wordc && !strncmp(tab->wordv[n], key, len) && !tab->wordv[n][len];
+}
+
+/* Tells whether the argument arg leaves the next one to be the value of
+ * an option, giving the word of this option, "-c=" or "--name=", in
+ * key. */
+static char wants_value(const struct atrcomptab* tab, const char* arg, size_t len, char* key, size_t* keylen)
+{
+    if (len < 2 || arg[0] != '-')
+        return 0;
+    if (arg[1] == '-')
+    {
+        if (len == 2 || memchr(arg, '=', len) || len+2 > *keylen)
+            return 0;
+        memcpy(key, arg, len);
+        key[len]='=';
+        *keylen=len+1;
+        return has_word(tab, key, len+1);
+    }
+    /* As in the parse, only the last character of a cluster takes the
+     * next argument as its value. */
+    key[0]='-';
+    key[1]=arg[len-1];
+    key[2]='=';
+    *keylen=3;
+    return has_word(tab, key, 3);
+}
+
+/* Adds to a completion the words beginning with the len first
+ * characters of key, from their character skip on, into comp->candv
+ * and buf if comp->candv is not NULL. Completing a value, eq is the
+ * position of the '=' in key, and only the values of an enumeration
+ * are given; completing a name, eq is 0, and only the words of the
+ * options are, a short option without its '='. Returns the room the
+ * candidates take. */
+static size_t add_candidates(const struct atrcomptab* tab, const char* key, size_t len, size_t eq, size_t skip, struct atrcomp* comp, char* buf)
+{
+    size_t n;
+    size_t size=0;
+    for (n=lower_word(tab, key, len);n<tab->wordc && !strncmp(tab->wordv[n], key, len);n++)
+    {
+        const char* w=tab->wordv[n];
+        const char* sep=strchr(w, '=');
+        size_t wlen;
+        if (eq ? !w[eq+1] : sep && sep[1])
+            continue;
+        wlen=strlen(w+skip);
+        if (!eq && sep && w[1] != '-')
+            wlen--;
+        if (comp->candv)
+        {
+            comp->candv[comp->candc]=buf+size;
+            memcpy(buf+size, w+skip, wlen);
+            buf[size+wlen]='\0';
+        }
+        comp->candc++;
+        size+=wlen+1;
+    }
+    return size;
+}
+
+/** Completes a command line.
+ *  This function gives the ways the word under the cursor can go on:
+ *  the short and long options beginning with it, when it begins with a
+ *  dash, or the values of an enumeration when it is the value of an
+ *  %option, either after the '=' of a long %option or as the argument
+ *  following one. It also tells whether a value is expected, in which
+ *  case a shell would rather complete a file name when no candidate is
+ *  given. Nothing is completed after "--" or as a positional argument.
+ *  The first word is the name of the program. Completing within
+ *  "--name=", the candidates are the whole words, like the one typed;
+ *  otherwise, they replace the word under the cursor.
+ *
+ *  The words are found by a binary search in the table, so that a
+ *  completion takes a few microseconds with thousands of options. With
+ *  bash, a program run as <tt>complete -C prog prog</tt> finds the line
+ *  in the COMP_LINE environment variable and the cursor in COMP_POINT,
+ *  and prints the candidates, one per line. You have to free the
+ *  completion calling delete_completion.
+ *  @param[in] tab The completion table.
+ *  @param[in] line The command line.
+ *  @param[in] point The position of the cursor in line, which is cut
+ *  there.
+ *  @return A pointer to the newly allocated completion, or NULL on a
+ *  failure.
+ */
+struct atrcomp* complete_line(const struct atrcomptab* tab, const char* line, size_t point)
+{
+    const char* prev=NULL;
+    const char* cur;
+    const char* key;
+    char* keybuf;
+    size_t prevlen=0;
+    size_t curlen=0;
+    size_t keylen;
+    size_t eq=0;
+    size_t skip=0;
+    size_t size=0;
+    size_t i=0;
+    size_t k=0;
+    char dashdash=0;
+    struct atrcomp* comp;
+    struct atrcomp count;
+    while (line[i] && i < point)
+        i++;
+    point=i;
+    cur=line+point;
+    for (i=0;i<point;)
+    {
+        size_t start;
+        while (i < point && isspace((unsigned char) line[i]))
+            i++;
+        if (i == point)
+            break;
+        start=i;
+        while (i < point && !isspace((unsigned char) line[i]))
+            i++;
+        if (i == point)
+        {
+            cur=line+start;
+            curlen=i-start;
+            break;
+        }
+        if (k && i-start == 2 && !strncmp(line+start, "--", 2))
+            dashdash=1;
+        prev=line+start;
+        prevlen=i-start;
+        k++;
+    }
+    comp = smalloc(sizeof *comp);
+    keybuf = smalloc(prevlen+curlen+3);
+    if (!comp || !keybuf)
+    {
+        sfree(keybuf);
+        sfree(comp);
+        return NULL;
+    }
+    comp->value=0;
+    count.candc=0;
+    count.candv=NULL;
+    key=cur;
+    keylen=prevlen+curlen+3;
+    if (!k || dashdash)
+        keylen=0;
+    else if (k > 1 && wants_value(tab, prev, prevlen, keybuf, &keylen))
+    {
+        comp->value=1;
+        memcpy(keybuf+keylen, cur, curlen);
+        key=keybuf;
+        eq=keylen-1;
+        skip=keylen;
+        keylen+=curlen;
+    }
+    else if (curlen > 2 && !strncmp(cur, "--", 2) && memchr(cur, '=', curlen))
+    {
+        comp->value=1;
+        eq=(const char*) memchr(cur, '=', curlen)-cur;
+        keylen=curlen;
+    }
+    else if (curlen && *cur == '-')
+        keylen=curlen;
+    else
+        keylen=0;
+    if (keylen)
+        size=add_candidates(tab, key, keylen, eq, skip, &count, NULL);
+    comp->candc=0;
+    comp->candv = smalloc((sizeof *comp->candv)*(count.candc+1)+size);
+    if (comp->candv)
+    {
+        if (keylen)
+            add_candidates(tab, key, keylen, eq, skip, comp, (char*) (comp->candv+count.candc+1));
+        comp->candv[comp->candc]=NULL;
+    }
+    else
+    {
+        sfree(comp);
+        comp=NULL;
+    }
+    sfree(keybuf);
+    return comp;
+}
+
+/** Deletes safely a completion.
+ *  This function frees a completion created with complete_line and
+ *  assigns the pointer to NULL. If NULL is passed as pointer, no action
+ *  is performed.
+ *  @param[in,out] ptr The address of the pointer to the completion.
+ */
+void delete_completion(struct atrcomp** ptr)
+{
+    if (*ptr)
+    {
+        sfree((*ptr)->candv);
+        sfree(*ptr);
+        *ptr=NULL;
+    }
+}
@@ -18,6 +18,7 @@ int main(int argc,char** argv)
     → SIGSEGV, so to be fixed… improving the destructor.
     */
     srand(getpid());
+    set_debug_allocator(999999);
     optv = new_option_table(3);
     if (optv)
     {
@@ -0,0 +1,631 @@
+/*
+ *  Libstropt: an easy to use library about command-line options parsing
+ *  Copyright (C) 2010 Paul Bazin
+ *
+ *  This file is part of Libstrotp.
+ *
+ *  This libray is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ *  @file
+ *  getopt_long() compatible front end.
+ *  @author Paul Bazin
+ *  @date 2010
+ *  @version 0.9-a2
+ *
+ *  This file contains atropt_getopt_long and atropt_getopt_long_only,
+ *  which behave as the functions of the GNU C library, but look the
+ *  options up in an index compiled from the table on the first call,
+ *  instead of scanning the table for each argument.
+ */
+
+#define _POSIX_C_SOURCE 200112L
+#include <stdio.h>
+#include <unistd.h>
+#include "stropt.h"
+#include "index.h"
+#include "scan.h"
+#include "stropt_getopt.h"
+
+void* smalloc(size_t);
+void* srealloc(void*, size_t);
+void sfree(void*);
+
+/* Number of tables whose index is kept. */
+#define CACHE 8
+
+/* How a short option takes its argument. */
+enum
+{
+    ARG_NONE,
+    ARG_REQUIRED,
+    ARG_OPTIONAL,
+    ARG_LONG
+};
+
+enum
+{
+    PERMUTE,
+    REQUIRE_ORDER,
+    RETURN_IN_ORDER
+};
+
+/* The index compiled for a table and an optstring, and what getopt
+ * needs besides: the long options sorted by name, for the
+ * abbreviations, and how each short option takes its argument. Option
+ * structure n is the long option n of the table for n < longc, and a
+ * short option afterwards. */
+struct gotable
+{
+    const struct atrlongopt* longopts;
+    const char* optstring;
+    struct optidx* idx;
+    struct option** optv;
+    size_t longc;
+    size_t empty;
+    const struct atrlongopt** byname;
+    char* mode;
+};
+
+/* What getopt keeps from one call to the next. */
+struct gostate
+{
+    char initialized;
+    char ordering;
+    char* nextchar;
+    int first_nonopt;
+    int last_nonopt;
+    int optopt;
+};
+
+static struct gotable cache[CACHE];
+static size_t cache_next;
+static struct gostate state;
+
+static int cmp_name(const void* a, const void* b)
+{
+    const struct atrlongopt* p = *(const struct atrlongopt* const*) a;
+    const struct atrlongopt* q = *(const struct atrlongopt* const*) b;
+    int r = strcmp(p->name, q->name);
+    if (!r)
+        r = p < q ? -1 : p > q;
+    return r;
+}
+
+static void delete_table(struct gotable* t)
+{
+    delete_option_index(&t->idx);
+    sfree(t->optv);
+    t->optv=NULL;
+    t->longopts=NULL;
+    t->optstring=NULL;
+}
+
+/* Compiles the index of a table, the option structures, the names and
+ * the modes living in one block. */
+static int new_table(struct gotable* t, const char* optstring, const struct atrlongopt* longopts)
+{
+    static const struct option blank = STATIC_OPTION(NULL, NULL, NULL, NULL, 0);
+    char seen[UCHAR_MAX+1];
+    size_t longc=0;
+    size_t shortc=0;
+    size_t optc;
+    size_t n;
+    const char* s=optstring;
+    struct option* opts;
+    const char** names;
+    char* shorts;
+    if (*s == '-' || *s == '+')
+        s++;
+    if (longopts)
+        while (longopts[longc].name)
+            longc++;
+    memset(seen, 0, sizeof seen);
+    for (n=0;s[n];n++)
+        if (s[n] != ':' && s[n] != ';' && !seen[(unsigned char) s[n]])
+        {
+            seen[(unsigned char) s[n]]=1;
+            shortc++;
+        }
+    optc=longc+shortc;
+    t->optv = smalloc((sizeof *t->optv)*(optc+1) + (sizeof *opts)*optc + (sizeof *names)*2*longc
+                      + (sizeof *t->byname)*longc + 3*shortc);
+    if (!t->optv)
+        return -1;
+    opts=(struct option*) (t->optv+optc+1);
+    names=(const char**) (opts+optc);
+    t->byname=(const struct atrlongopt**) (names+2*longc);
+    shorts=(char*) (t->byname+longc);
+    t->mode=shorts+2*shortc;
+    t->longc=longc;
+    t->empty=longc;
+    for (n=0;n<longc;n++)
+    {
+        opts[n]=blank;
+        /* An empty name is only reached as an abbreviation. */
+        if (*longopts[n].name)
+        {
+            names[2*n]=longopts[n].name;
+            names[2*n+1]=NULL;
+            opts[n].long_act=names+2*n;
+        }
+        else if (t->empty == longc)
+            t->empty=n;
+        t->optv[n]=opts+n;
+        t->byname[n]=longopts+n;
+    }
+    qsort(t->byname, longc, sizeof *t->byname, cmp_name);
+    /* As getopt finds each character with strchr, the first occurrence
+     * tells how it takes its argument. */
+    memset(seen, 0, sizeof seen);
+    for (n=0;*s;s++)
+        if (*s != ':' && *s != ';' && !seen[(unsigned char) *s])
+        {
+            seen[(unsigned char) *s]=1;
+            shorts[2*n]=*s;
+            shorts[2*n+1]='\0';
+            if (s[0] == 'W' && s[1] == ';' && longopts)
+                t->mode[n]=ARG_LONG;
+            else if (s[1] == ':')
+                t->mode[n] = s[2] == ':' ? ARG_OPTIONAL : ARG_REQUIRED;
+            else
+                t->mode[n]=ARG_NONE;
+            opts[longc+n]=blank;
+            opts[longc+n].short_act=shorts+2*n;
+            t->optv[longc+n]=opts+longc+n;
+            n++;
+        }
+    t->optv[optc]=NULL;
+    t->idx=new_option_index(t->optv);
+    if (!t->idx)
+    {
+        delete_table(t);
+        return -1;
+    }
+    t->longopts=longopts;
+    t->optstring=optstring;
+    return 0;
+}
+
+/* Returns the index of a table, compiling it unless it is cached. The
+ * tables are told apart by their address only. */
+static const struct gotable* find_table(const char* optstring, const struct atrlongopt* longopts)
+{
+    struct gotable* t;
+    size_t n;
+    for (n=0;n<CACHE;n++)
+        if (cache[n].idx && cache[n].optstring == optstring && cache[n].longopts == longopts)
+            return cache+n;
+    t=cache+cache_next;
+    cache_next=(cache_next+1)%CACHE;
+    delete_table(t);
+    if (new_table(t, optstring, longopts))
+        return NULL;
+    return t;
+}
+
+/** Forgets the indexes compiled by atropt_getopt_long.
+ *  The index of a table is kept as long as the table is given again
+ *  from the same address, with the same optstring. Call this function
+ *  when a table or an optstring is changed in place, or freed while
+ *  another one may be allocated at the same address, and to free the
+ *  memory of the indexes.
+ */
+void clear_getopt_cache(void)
+{
+    size_t n;
+    for (n=0;n<CACHE;n++)
+        delete_table(cache+n);
+}
+
+/* Gives how the short option c takes its argument, or -1 if it is not
+ * an option character. */
+static int short_mode(const struct gotable* t, char c)
+{
+    const struct optidx* idx=t->idx;
+    unsigned char u=c;
+    if (idx->short_first[u] == idx->short_first[u+1])
+        return -1;
+    return t->mode[idx->short_ent[idx->short_first[u]].opt - t->longc];
+}
+
+/* Gives the position in t->byname of the first name not sorted before
+ * the len first characters of name, or of the first one sorted after
+ * them if after is set. */
+static size_t bound(const struct gotable* t, const char* name, size_t len, char after)
+{
+    size_t lo=0;
+    size_t hi=t->longc;
+    while (lo < hi)
+    {
+        size_t mid=lo+(hi-lo)/2;
+        int r=strncmp(t->byname[mid]->name, name, len);
+        if (r < 0 || (after && !r))
+            lo=mid+1;
+        else
+            hi=mid;
+    }
+    return lo;
+}
+
+static void print_ambiguous(const struct gotable* t, char* const* argv, const char* prefix, size_t lo, size_t hi, long found, char long_only)
+{
+    const struct atrlongopt* pfound=t->longopts+found;
+    char* set = smalloc(t->longc);
+    size_t n;
+    if (!set)
+    {
+        fprintf(stderr, "%s: option '%s%s' is ambiguous\n", argv[0], prefix, state.nextchar);
+        return;
+    }
+    memset(set, 0, t->longc);
+    set[found]=1;
+    for (n=lo;n<hi;n++)
+    {
+        const struct atrlongopt* p=t->byname[n];
+        if (long_only || p->has_arg != pfound->has_arg || p->flag != pfound->flag || p->val != pfound->val)
+            set[p-t->longopts]=1;
+    }
+    fprintf(stderr, "%s: option '%s%s' is ambiguous; possibilities:", argv[0], prefix, state.nextchar);
+    for (n=0;n<t->longc;n++)
+        if (set[n])
+            fprintf(stderr, " '%s%s'", prefix, t->longopts[n].name);
+    fputc('\n', stderr);
+    sfree(set);
+}
+
+/* Handles the long option at state.nextchar, returning -1 if getopt
+ * should try it as short options instead. */
+static int long_option(int argc, char* const* argv, const char* optstring, const struct gotable* t, int* longind, char long_only, char print, const char* prefix)
+{
+    const char* name=state.nextchar;
+    char* nameend=(char*) scan_eq(state.nextchar);
+    const struct atrlongopt* p;
+    long found=-1;
+    size_t len;
+    len=nameend-name;
+    if (!len)
+    {
+        if (t->empty < t->longc)
+            found=t->empty;
+    }
+    else
+    {
+        const struct optname* nm=long_lookup(t->idx, name, len, NULL);
+        if (nm)
+            found=t->idx->long_ent[nm->first].opt;
+    }
+    if (found < 0)
+    {
+        /* The abbreviations of a name follow each other in byname. As
+         * getopt takes the first one in the table, the others only
+         * make it ambiguous if they are different options. */
+        size_t lo=bound(t, name, len, 0);
+        size_t hi=bound(t, name, len, 1);
+        char ambiguous=0;
+        size_t n;
+        for (n=lo;n<hi;n++)
+            if (found < 0 || t->byname[n]-t->longopts < found)
+                found=t->byname[n]-t->longopts;
+        for (n=lo;n<hi && !ambiguous;n++)
+        {
+            p=t->byname[n];
+            ambiguous = p-t->longopts != found && (long_only || p->has_arg != t->longopts[found].has_arg
+                                                    || p->flag != t->longopts[found].flag || p->val != t->longopts[found].val);
+        }
+        if (ambiguous)
+        {
+            if (print)
+                print_ambiguous(t, argv, prefix, lo, hi, found, long_only);
+            state.nextchar += strlen(state.nextchar);
+            optind++;
+            state.optopt=0;
+            return '?';
+        }
+    }
+    if (found < 0)
+    {
+        if (!long_only || argv[optind][1] == '-' || !strchr(optstring, *state.nextchar))
+        {
+            if (print)
+                fprintf(stderr, "%s: unrecognized option '%s%s'\n", argv[0], prefix, state.nextchar);
+            state.nextchar=NULL;
+            optind++;
+            state.optopt=0;
+            return '?';
+        }
+        return -1;
+    }
+    p=t->longopts+found;
+    optind++;
+    state.nextchar=NULL;
+    if (*nameend)
+    {
+        if (p->has_arg)
+            optarg=nameend+1;
+        else
+        {
+            if (print)
+                fprintf(stderr, "%s: option '%s%s' doesn't allow an argument\n", argv[0], prefix, p->name);
+            state.optopt=p->val;
+            return '?';
+        }
+    }
+    else if (p->has_arg == 1)
+    {
+        if (optind < argc)
+            optarg=argv[optind++];
+        else
+        {
+            if (print)
+                fprintf(stderr, "%s: option '%s%s' requires an argument\n", argv[0], prefix, p->name);
+            state.optopt=p->val;
+            return optstring[0] == ':' ? ':' : '?';
+        }
+    }
+    if (longind)
+        *longind=found;
+    if (p->flag)
+    {
+        *p->flag=p->val;
+        return 0;
+    }
+    return p->val;
+}
+
+/* Moves the options found between the non-options already skipped,
+ * argv[first_nonopt] to argv[last_nonopt], and argv[optind] before
+ * them. */
+static void exchange(char** argv)
+{
+    int bottom=state.first_nonopt;
+    int middle=state.last_nonopt;
+    int top=optind;
+    while (top > middle && middle > bottom)
+    {
+        int n;
+        if (top-middle > middle-bottom)
+        {
+            int len=middle-bottom;
+            for (n=0;n<len;n++)
+            {
+                char* tmp=argv[bottom+n];
+                argv[bottom+n]=argv[top-len+n];
+                argv[top-len+n]=tmp;
+            }
+            top-=len;
+        }
+        else
+        {
+            int len=top-middle;
+            for (n=0;n<len;n++)
+            {
+                char* tmp=argv[bottom+n];
+                argv[bottom+n]=argv[middle+n];
+                argv[middle+n]=tmp;
+            }
+            bottom+=len;
+        }
+    }
+    state.first_nonopt += optind-state.last_nonopt;
+    state.last_nonopt=optind;
+}
+
+#define NONOPTION(arg) ((arg)[0] != '-' || (arg)[1] == '\0')
+
+static int next_option(int argc, char* const* argv, const char* optstring, const struct atrlongopt* longopts, int* longind, char long_only)
+{
+    const struct gotable* t;
+    char print = opterr != 0;
+    char c;
+    int mode;
+    if (argc < 1)
+        return -1;
+    optarg=NULL;
+    t=find_table(optstring, longopts);
+    if (optind == 0 || !state.initialized)
+    {
+        if (optind == 0)
+            optind=1;
+        state.first_nonopt=optind;
+        state.last_nonopt=optind;
+        state.nextchar=NULL;
+        if (optstring[0] == '-')
+        {
+            state.ordering=RETURN_IN_ORDER;
+            optstring++;
+        }
+        else if (optstring[0] == '+')
+        {
+            state.ordering=REQUIRE_ORDER;
+            optstring++;
+        }
+        else if (getenv("POSIXLY_CORRECT"))
+            state.ordering=REQUIRE_ORDER;
+        else
+            state.ordering=PERMUTE;
+        state.initialized=1;
+    }
+    else if (optstring[0] == '-' || optstring[0] == '+')
+        optstring++;
+    if (optstring[0] == ':')
+        print=0;
+    if (!t)
+    {
+        state.optopt=0;
+        return '?';
+    }
+
+    if (!state.nextchar || !*state.nextchar)
+    {
+        /* The caller may have moved optind back. */
+        if (state.last_nonopt > optind)
+            state.last_nonopt=optind;
+        if (state.first_nonopt > optind)
+            state.first_nonopt=optind;
+        if (state.ordering == PERMUTE)
+        {
+            if (state.first_nonopt != state.last_nonopt && state.last_nonopt != optind)
+                exchange((char**) argv);
+            else if (state.last_nonopt != optind)
+                state.first_nonopt=optind;
+            while (optind < argc && NONOPTION(argv[optind]))
+                optind++;
+            state.last_nonopt=optind;
+        }
+        if (optind != argc && !strcmp(argv[optind], "--"))
+        {
+            optind++;
+            if (state.first_nonopt != state.last_nonopt && state.last_nonopt != optind)
+                exchange((char**) argv);
+            else if (state.first_nonopt == state.last_nonopt)
+                state.first_nonopt=optind;
+            state.last_nonopt=argc;
+            optind=argc;
+        }
+        if (optind == argc)
+        {
+            if (state.first_nonopt != state.last_nonopt)
+                optind=state.first_nonopt;
+            return -1;
+        }
+        if (NONOPTION(argv[optind]))
+        {
+            if (state.ordering == REQUIRE_ORDER)
+                return -1;
+            optarg=argv[optind++];
+            return 1;
+        }
+        if (longopts)
+        {
+            if (argv[optind][1] == '-')
+            {
+                state.nextchar=argv[optind]+2;
+                return long_option(argc, argv, optstring, t, longind, long_only, print, "--");
+            }
+            if (long_only && (argv[optind][2] || !strchr(optstring, argv[optind][1])))
+            {
+                int code;
+                state.nextchar=argv[optind]+1;
+                code=long_option(argc, argv, optstring, t, longind, long_only, print, "-");
+                if (code != -1)
+                    return code;
+            }
+        }
+        state.nextchar=argv[optind]+1;
+    }
+
+    c=*state.nextchar++;
+    mode=short_mode(t, c);
+    if (!*state.nextchar)
+        optind++;
+    if (mode < 0)
+    {
+        if (print)
+            fprintf(stderr, "%s: invalid option -- '%c'\n", argv[0], c);
+        state.optopt=c;
+        return '?';
+    }
+    if (mode == ARG_LONG)
+    {
+        /* -W foo is --foo. */
+        if (!*state.nextchar)
+        {
+            if (optind == argc)
+            {
+                if (print)
+                    fprintf(stderr, "%s: option requires an argument -- '%c'\n", argv[0], c);
+                state.optopt=c;
+                return optstring[0] == ':' ? ':' : '?';
+            }
+            state.nextchar=argv[optind];
+        }
+        return long_option(argc, argv, optstring, t, longind, 0, print, "-W ");
+    }
+    if (mode == ARG_OPTIONAL)
+    {
+        if (*state.nextchar)
+        {
+            optarg=state.nextchar;
+            optind++;
+        }
+        state.nextchar=NULL;
+    }
+    else if (mode == ARG_REQUIRED)
+    {
+        if (*state.nextchar)
+        {
+            optarg=state.nextchar;
+            optind++;
+        }
+        else if (optind == argc)
+        {
+            if (print)
+                fprintf(stderr, "%s: option requires an argument -- '%c'\n", argv[0], c);
+            state.optopt=c;
+            c = optstring[0] == ':' ? ':' : '?';
+        }
+        else
+            optarg=argv[optind++];
+        state.nextchar=NULL;
+    }
+    return c;
+}
+
+/** Parses the command-line arguments as getopt_long does.
+ *  This function behaves as getopt_long of the GNU C library: it takes
+ *  the same optstring and table, sets the same optind, optarg and
+ *  optopt variables, permutes argv in the same way and prints the same
+ *  error messages, unless opterr is 0 or optstring begins with ':'.
+ *  Setting optind to 0 starts a new parse, as with getopt_long.
+ *
+ *  Instead of scanning the table for each argument, the options are
+ *  looked up in an index compiled on the first call for the table and
+ *  optstring, then kept for the next calls made with the same
+ *  addresses; clear_getopt_cache forgets it. If the index cannot be
+ *  compiled for lack of memory, '?' is returned with optopt set to 0.
+ *
+ *  As with getopt_long, the state kept from one call to the next is
+ *  shared by the whole program, which must parse in one thread at a
+ *  time; it is not shared with getopt_long.
+ *  @param[in] argc The number of arguments, as passed to main.
+ *  @param[in] argv The arguments, as passed to main.
+ *  @param[in] optstring The short options, as for getopt_long.
+ *  @param[in] longopts The long options, terminated by an element
+ *  whose name is NULL, or NULL.
+ *  @param[out] longindex Where to write the index in longopts of the
+ *  long option found, or NULL.
+ *  @return What getopt_long returns: the option character or val
+ *  member found, 0 if its flag member was set, 1 for a non-option in
+ *  the '-' mode, '?' or ':' on an error, and -1 at the end.
+ */
+int atropt_getopt_long(int argc, char* const* argv, const char* optstring, const struct atrlongopt* longopts, int* longindex)
+{
+    int c=next_option(argc, argv, optstring, longopts, longindex, 0);
+    optopt=state.optopt;
+    return c;
+}
+
+/** Parses the command-line arguments as getopt_long_only does.
+ *  This function works as atropt_getopt_long, but an argument beginning
+ *  with a single '-' is looked up as a long option first, as
+ *  getopt_long_only does.
+ */
+int atropt_getopt_long_only(int argc, char* const* argv, const char* optstring, const struct atrlongopt* longopts, int* longindex)
+{
+    int c=next_option(argc, argv, optstring, longopts, longindex, 1);
+    optopt=state.optopt;
+    return c;
+}
@@ -0,0 +1,329 @@
+/*
+ *  Libstropt: an easy to use library about command-line options parsing
+ *  Copyright (C) 2010 Paul Bazin
+ *
+ *  This file is part of Libstrotp.
+ *
+ *  This libray is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ *  @file
+ *  %Option index compilation.
+ *  @author Paul Bazin
+ *  @date 2010
+ *  @version 0.9-a2
+ *
+ *  This file contains the functions turning a table of option
+ *  structures into the dispatch tables used by atropt, so that each
+ *  %option argument is matched by a lookup instead of a scan of every
+ *  option structure: a table indexed by character for the short
+ *  options, and a hash table of the names for the long ones.
+ */
+
+#define _POSIX_C_SOURCE 200112L
+#include <pthread.h>
+#include "stropt.h"
+#include "index.h"
+#include "scan.h"
+
+void* smalloc(size_t);
+void* srealloc(void*, size_t);
+void sfree(void*);
+
+static size_t hash_name(const char* name, size_t len)
+{
+    size_t h=2166136261u;
+    size_t i;
+    for (i=0;i<len;i++)
+        h = (h ^ (unsigned char) name[i]) * 16777619u;
+    return h;
+}
+
+/* Returns the slot holding name, or the empty slot where to insert it. */
+static size_t* find_slot(const struct optidx* idx, const char* name, size_t len, size_t* cmps)
+{
+    size_t n=0;
+    size_t h=hash_name(name, len) & idx->long_mask;
+    while (idx->long_slot[h])
+    {
+        const struct optname* nm = idx->long_name + idx->long_slot[h] - 1;
+        if (nm->len == len)
+        {
+            n++;
+            if (scan_same(nm->name, name, len))
+                break;
+        }
+        h = (h+1) & idx->long_mask;
+    }
+    if (cmps)
+        *cmps+=n;
+    return idx->long_slot + h;
+}
+
+/** Looks up a long %option name in an index.
+ *  The name does not need to be terminated: it is compared on len
+ *  characters only, so the caller can pass the part of an argument
+ *  preceding the '='. The number of string comparisons done is added
+ *  to *cmps, unless cmps is NULL.
+ */
+const struct optname* long_lookup(const struct optidx* idx, const char* name, size_t len, size_t* cmps)
+{
+    size_t slot = *find_slot(idx, name, len, cmps);
+    if (slot)
+        return idx->long_name + slot - 1;
+    return NULL;
+}
+
+/* Counts the entries of each distinct long name when ent is NULL, or
+ * fills ent in option order. */
+static void each_long(struct optidx* idx, struct optent* ent)
+{
+    size_t optn;
+    for (optn=0;optn<idx->optc;optn++)
+    {
+        int act;
+        for (act=1;act>=0;act--)
+        {
+            const char** long_;
+            if (act)
+                long_ = idx->optv[optn]->long_act;
+            else
+                long_ = idx->optv[optn]->long_unact;
+            for (;long_ && *long_;long_++)
+            {
+                size_t len = strlen(*long_);
+                size_t* slot = find_slot(idx, *long_, len, NULL);
+                struct optname* nm;
+                if (!*slot)
+                {
+                    nm = idx->long_name + idx->long_namec++;
+                    nm->name = *long_;
+                    nm->len = len;
+                    nm->first = 0;
+                    nm->count = 0;
+                    nm->sig = name_sig(*long_, len);
+                    *slot = idx->long_namec;
+                }
+                nm = idx->long_name + *slot - 1;
+                if (ent)
+                {
+                    ent[nm->first].opt = optn;
+                    ent[nm->first++].act = (char) act;
+                }
+                else
+                    nm->count++;
+            }
+        }
+    }
+}
+
+static int cmp_len(const void* a, const void* b)
+{
+    size_t la = (*(const struct optname* const*) a)->len;
+    size_t lb = (*(const struct optname* const*) b)->len;
+    return la < lb ? -1 : la > lb;
+}
+
+static int compile_long(struct optidx* idx)
+{
+    int r=-1;
+    size_t regc=0;
+    size_t optn;
+    size_t size=1;
+    for (optn=0;optn<idx->optc;optn++)
+    {
+        const char** long_;
+        for (long_=idx->optv[optn]->long_act;long_ && *long_;long_++)
+            regc++;
+        for (long_=idx->optv[optn]->long_unact;long_ && *long_;long_++)
+            regc++;
+    }
+    while (size < 2*regc)
+        size *= 2;
+    idx->long_mask = size-1;
+    idx->long_namec = 0;
+    idx->long_slot = smalloc((sizeof *idx->long_slot)*size);
+    idx->long_name = smalloc((sizeof *idx->long_name)*(regc+1));
+    idx->long_ent = smalloc((sizeof *idx->long_ent)*(regc+1));
+    idx->long_bylen = smalloc((sizeof *idx->long_bylen)*(regc+1));
+    if (idx->long_slot && idx->long_name && idx->long_ent && idx->long_bylen)
+    {
+        size_t n;
+        size_t first=0;
+        for (n=0;n<size;n++)
+            idx->long_slot[n]=0;
+        each_long(idx, NULL);
+        for (n=0;n<idx->long_namec;n++)
+        {
+            idx->long_name[n].first = first;
+            first += idx->long_name[n].count;
+        }
+        each_long(idx, idx->long_ent);
+        for (n=0;n<idx->long_namec;n++)
+        {
+            idx->long_name[n].first -= idx->long_name[n].count;
+            idx->long_bylen[n] = idx->long_name + n;
+        }
+        qsort(idx->long_bylen, idx->long_namec, sizeof *idx->long_bylen, cmp_len);
+        r=0;
+    }
+    return r;
+}
+
+/* Calls f(c, act, n, data) once for each distinct character of the
+ * short activators, then once for each distinct character of the short
+ * unactivators of option n. */
+static void each_short(struct option* opt, size_t n, size_t* seen,
+                       void (*f)(unsigned char, char, size_t, void*), void* data)
+{
+    const char* s;
+    for (s=opt->short_act;s && *s;s++)
+        if (seen[(unsigned char) *s] != 2*n+1)
+        {
+            seen[(unsigned char) *s] = 2*n+1;
+            f((unsigned char) *s, 1, n, data);
+        }
+    for (s=opt->short_unact;s && *s;s++)
+        if (seen[(unsigned char) *s] != 2*n+2)
+        {
+            seen[(unsigned char) *s] = 2*n+2;
+            f((unsigned char) *s, 0, n, data);
+        }
+}
+
+static void count_short(unsigned char c, char act, size_t n, void* data)
+{
+    (void) act;
+    (void) n;
+    ((size_t*) data)[c+1]++;
+}
+
+static void fill_short(unsigned char c, char act, size_t n, void* data)
+{
+    struct optidx* idx = data;
+    struct optent* ent = idx->short_ent + idx->short_first[c]++;
+    ent->opt=n;
+    ent->act=act;
+}
+
+/** Compiles a table of option structures into an index.
+ *  This function builds the dispatch tables atropt_index needs to
+ *  match the %option arguments: each short %option character is then
+ *  resolved by a single lookup, whatever the number of option
+ *  structures, and each long %option name by a hash lookup. The index
+ *  refers to the table and reads the options once, at compilation: if
+ *  you update the option structures with set_short_options or
+ *  new_long_option, or change their takes_value or borrow members
+ *  afterwards, you have to build a new index.
+ *  The table must stay allocated as long as the index is used. You
+ *  have to free the index calling delete_option_index once you no
+ *  longer need it.
+ *  @param[in] optv A table of option structures terminated by NULL.
+ *  @return A pointer to the newly allocated index, or NULL on a
+ *  failure.
+ */
+struct optidx* new_option_index(struct option** optv)
+{
+    size_t seen[UCHAR_MAX+1];
+    size_t optn;
+    int c;
+    struct optidx* idx = smalloc(sizeof *idx);
+    if (idx)
+    {
+        idx->optv=optv;
+        idx->spec=NULL;
+        idx->long_slot=NULL;
+        idx->long_name=NULL;
+        idx->long_ent=NULL;
+        idx->long_bylen=NULL;
+        for (c=0;c<=UCHAR_MAX+1;c++)
+            idx->short_first[c]=0;
+        for (c=0;c<=UCHAR_MAX;c++)
+            seen[c]=0;
+        for (optn=0;optv[optn];optn++)
+            each_short(optv[optn], optn, seen, count_short, idx->short_first);
+        idx->optc=optn;
+        idx->spec = smalloc((sizeof *idx->spec)*(optn+1));
+        if (idx->spec)
+            for (optn=0;optn<idx->optc;optn++)
+            {
+                idx->spec[optn].takes_value = optv[optn]->takes_value;
+                idx->spec[optn].borrow = optv[optn]->borrow;
+                idx->spec[optn].type = optv[optn]->value_type;
+                idx->spec[optn].enumv = optv[optn]->value_enum;
+            }
+        for (c=1;c<=UCHAR_MAX+1;c++)
+            idx->short_first[c] += idx->short_first[c-1];
+        idx->short_ent = smalloc((sizeof *idx->short_ent)*(idx->short_first[UCHAR_MAX+1]+1));
+        if (idx->short_ent)
+        {
+            /* Filling moves each short_first[c] up to short_first[c+1],
+             * so the table is shifted back afterwards. */
+            for (c=0;c<=UCHAR_MAX;c++)
+                seen[c]=0;
+            for (optn=0;optv[optn];optn++)
+                each_short(optv[optn], optn, seen, fill_short, idx);
+            for (c=UCHAR_MAX+1;c>0;c--)
+                idx->short_first[c] = idx->short_first[c-1];
+            idx->short_first[0]=0;
+        }
+        if (!idx->spec || !idx->short_ent || compile_long(idx))
+            delete_option_index(&idx);
+    }
+    return idx;
+}
+
+/** Deletes safely an index.
+ *  This function frees an index created with new_option_index, and
+ *  assigns the pointer to NULL. The option structures indexed are left
+ *  untouched. If NULL is passed as pointer, no action is performed.
+ *  @param[in,out] ptr The address of the pointer to the index.
+ */
+void delete_option_index(struct optidx** ptr)
+{
+    if (*ptr)
+    {
+        sfree((*ptr)->spec);
+        sfree((*ptr)->short_ent);
+        sfree((*ptr)->long_slot);
+        sfree((*ptr)->long_name);
+        sfree((*ptr)->long_ent);
+        sfree((*ptr)->long_bylen);
+        sfree(*ptr);
+        *ptr=NULL;
+    }
+}
+
+/** Gives the index of a statically declared table, building it once.
+ *  The first call builds the index of decl->optv, as new_option_index
+ *  does, and keeps it in decl->idx; the next ones just return it. The
+ *  calls may come from several threads at once. The index is never
+ *  freed, unless you call delete_option_index on decl->idx once no
+ *  longer used.
+ *  @param[in,out] decl A declaration initialized with STATIC_INDEX.
+ *  @return The index, or NULL if it cannot be built; a next call then
+ *  tries again.
+ */
+const struct optidx* declared_index(struct optdecl* decl)
+{
+    static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+    const struct optidx* idx;
+    pthread_mutex_lock(&lock);
+    if (!decl->idx)
+        decl->idx = new_option_index(decl->optv);
+    idx=decl->idx;
+    pthread_mutex_unlock(&lock);
+    return idx;
+}
@@ -0,0 +1,92 @@
+/*
+ *  Libstropt: an easy to use library about command-line options parsing
+ *  Copyright (C) 2010 Paul Bazin
+ *
+ *  This file is part of Libstrotp.
+ *
+ *  This libray is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ *  @file
+ *  Compiled %option index.
+ *  The layout of the index built by new_option_index() is shared
+ *  between index.c, which builds it, and atropt.c, which reads it. It
+ *  is not part of the API.
+ */
+
+#ifndef H_INDEX
+#define H_INDEX
+#include <limits.h>
+
+/** One option reached through a short %option character. */
+struct optent
+{
+    size_t opt;
+    char act;
+};
+
+/** What the parse needs to know about an option structure. */
+struct optspec
+{
+    char takes_value;
+    char borrow;
+    char type;
+    const char* const* enumv;
+};
+
+/** One distinct long %option name.
+ *  Its entries are long_ent[first] up to long_ent[first+count]
+ *  excluded.
+ */
+struct optname
+{
+    const char* name;
+    size_t len;
+    size_t first;
+    size_t count;
+    unsigned long sig;
+};
+
+/** Dispatch tables compiled from a table of option structures.
+ *  The entries for the character c are short_ent[short_first[c]] up
+ *  to short_ent[short_first[c+1]] excluded, sorted by option, an
+ *  activator coming before an unactivator of the same option.
+ *  The long %option names are kept in an open addressing hash table of
+ *  long_mask+1 slots, each slot holding an index into long_name plus
+ *  one, or 0 when empty. The entries of a name are sorted as the short
+ *  ones, one entry per call to new_long_option. long_bylen lists the
+ *  names by increasing length, for the suggestions.
+ *  Apart from the long names, nothing the parse reads is shared with
+ *  the option structures, which the parse writes only when no result
+ *  structure is given.
+ */
+struct optidx
+{
+    struct option** optv;
+    size_t optc;
+    struct optspec* spec;
+    size_t short_first[UCHAR_MAX+2];
+    struct optent* short_ent;
+    size_t long_mask;
+    size_t* long_slot;
+    size_t long_namec;
+    struct optname* long_name;
+    struct optent* long_ent;
+    const struct optname** long_bylen;
+};
+
+const struct optname* long_lookup(const struct optidx*, const char*, size_t, size_t*);
+unsigned long name_sig(const char*, size_t);
+#endif /* H_INDEX */
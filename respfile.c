@@ -0,0 +1,207 @@
+/*
+ *  Libstropt: an easy to use library about command-line options parsing
+ *  Copyright (C) 2010 Paul Bazin
+ *
+ *  This file is part of Libstrotp.
+ *
+ *  This libray is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ *  @file
+ *  Response files.
+ *  @author Paul Bazin
+ *  @date 2010
+ *  @version 0.9-a2
+ *
+ *  This file contains the functions reading response files: the files
+ *  named by an '@' argument, whose tokens atropt_result parses as if
+ *  they were given in argv. A response file is mapped privately in
+ *  memory, and each token is terminated in place, by overwriting the
+ *  separator following it, as the parse reaches it: the tokens are
+ *  never copied, and the file itself is never modified. Configuration
+ *  files are read the same way, line by line.
+ */
+
+#define _POSIX_C_SOURCE 200112L
+#include <sys/types.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include "stropt.h"
+#include "respfile.h"
+
+void* smalloc(size_t);
+void* srealloc(void*, size_t);
+void sfree(void*);
+
+static int is_separator(const struct respfile* f, char c)
+{
+    if (f->nul)
+        return c == '\0';
+    return c == '\0' || isspace((unsigned char) c);
+}
+
+/** Opens and maps a response file.
+ *  The tokens of a file whose last character is '\0' are separated by
+ *  '\0', as written by find -print0 for xargs -0; the tokens of any
+ *  other file are separated by whitespaces.
+ *  @return The response file, or NULL if it cannot be read.
+ */
+struct respfile* open_respfile(const char* name)
+{
+    struct respfile* f=NULL;
+    struct stat st;
+    int fd = open(name, O_RDONLY);
+    if (fd != -1)
+    {
+        if (!fstat(fd, &st))
+            f = smalloc(sizeof *f);
+        if (f)
+        {
+            f->map=NULL;
+            f->size=st.st_size;
+            f->pos=0;
+            f->nul=0;
+            f->tail=NULL;
+            f->name=name;
+            f->argn=0;
+            f->up=NULL;
+            f->next=NULL;
+            if (f->size)
+            {
+                void* map = mmap(NULL, f->size, PROT_READ|PROT_WRITE, MAP_PRIVATE, fd, 0);
+                if (map != MAP_FAILED)
+                {
+                    f->map=map;
+                    f->nul = f->map[f->size-1] == '\0';
+                }
+                else
+                {
+                    sfree(f);
+                    f=NULL;
+                }
+            }
+        }
+        close(fd);
+    }
+    return f;
+}
+
+/** Splits the next token of a response file.
+ *  @param[in,out] f The response file.
+ *  @param[out] tok The token, terminated by '\0'.
+ *  @param[out] off The offset of the token in the file.
+ *  @return 1 if a token is given, 0 at the end of the file, -1 if an
+ *  internal error occurs.
+ */
+int respfile_token(struct respfile* f, const char** tok, size_t* off)
+{
+    size_t end;
+    while (f->pos < f->size && is_separator(f, f->map[f->pos]))
+        f->pos++;
+    if (f->pos >= f->size)
+        return 0;
+    *off=f->pos;
+    for (end=f->pos;end<f->size && !is_separator(f, f->map[end]);end++);
+    f->pos=end+1;
+    *tok = f->map + *off;
+    if (end < f->size)
+        f->map[end]='\0';
+    else if (!(f->size % sysconf(_SC_PAGESIZE)))
+    {
+        /* The token ends the last page: terminating it needs a copy.
+         * Otherwise the rest of the page is mapped, and zeroed. */
+        f->tail = smalloc(end - *off + 1);
+        if (!f->tail)
+            return -1;
+        memcpy(f->tail, f->map + *off, end - *off);
+        f->tail[end - *off]='\0';
+        *tok = f->tail;
+    }
+    return 1;
+}
+
+/** Splits the next setting of a configuration file.
+ *  A setting is a line "key=value", or "key" alone, the whitespaces
+ *  around the key and the value being ignored. Blank lines, and lines
+ *  starting with '#' or ';', are skipped.
+ *  @param[in,out] f The file.
+ *  @param[out] key The key, not terminated.
+ *  @param[out] len The length of the key.
+ *  @param[out] value The value, terminated by '\0'; or NULL if the line
+ *  has no '='.
+ *  @param[out] off The offset of the line in the file.
+ *  @return 1 if a setting is given, 0 at the end of the file, -1 if an
+ *  internal error occurs.
+ */
+int respfile_line(struct respfile* f, const char** key, size_t* len, const char** value, size_t* off)
+{
+    while (f->pos < f->size)
+    {
+        size_t start=f->pos;
+        size_t end;
+        size_t eq;
+        size_t k;
+        for (end=start;end<f->size && f->map[end] != '\n';end++);
+        f->pos=end+1;
+        while (start < end && isspace((unsigned char) f->map[start]))
+            start++;
+        while (end > start && isspace((unsigned char) f->map[end-1]))
+            end--;
+        if (start == end || f->map[start] == '#' || f->map[start] == ';')
+            continue;
+        for (eq=start;eq<end && f->map[eq] != '=';eq++);
+        for (k=eq;k>start && isspace((unsigned char) f->map[k-1]);k--);
+        *key = f->map + start;
+        *len = k-start;
+        *off=start;
+        *value=NULL;
+        if (eq < end)
+        {
+            size_t v=eq+1;
+            while (v < end && isspace((unsigned char) f->map[v]))
+                v++;
+            *value = f->map + v;
+            if (end < f->size)
+                f->map[end]='\0';
+            else if (!(f->size % sysconf(_SC_PAGESIZE)))
+            {
+                f->tail = smalloc(end - v + 1);
+                if (!f->tail)
+                    return -1;
+                memcpy(f->tail, f->map + v, end - v);
+                f->tail[end - v]='\0';
+                *value = f->tail;
+            }
+        }
+        return 1;
+    }
+    return 0;
+}
+
+/** Unmaps and frees a chain of response files. */
+void close_respfiles(struct respfile* f)
+{
+    while (f)
+    {
+        struct respfile* next = f->next;
+        if (f->map)
+            munmap(f->map, f->size);
+        sfree(f->tail);
+        sfree(f);
+        f=next;
+    }
+}
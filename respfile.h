@@ -0,0 +1,51 @@
+/*
+ *  Libstropt: an easy to use library about command-line options parsing
+ *  Copyright (C) 2010 Paul Bazin
+ *
+ *  This file is part of Libstrotp.
+ *
+ *  This libray is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ *  @file
+ *  Response file internals.
+ *  Functions reading the response files expanded by atropt_result().
+ *  They are not part of the API.
+ */
+
+#ifndef H_RESPFILE
+#define H_RESPFILE
+/** A response file, mapped in memory.
+ *  Its tokens are split lazily, from pos on. The files opened by a
+ *  parse are chained by next, and stacked by up while being read.
+ */
+struct respfile
+{
+    char* map;
+    size_t size;
+    size_t pos;
+    char nul;
+    char* tail;
+    const char* name;
+    int argn;
+    struct respfile* up;
+    struct respfile* next;
+};
+
+struct respfile* open_respfile(const char*);
+int respfile_token(struct respfile*, const char**, size_t*);
+int respfile_line(struct respfile*, const char**, size_t*, const char**, size_t*);
+void close_respfiles(struct respfile*);
+#endif /* H_RESPFILE */
@@ -0,0 +1,249 @@
+/*
+ *  Libstropt: an easy to use library about command-line options parsing
+ *  Copyright (C) 2010 Paul Bazin
+ *
+ *  This file is part of Libstrotp.
+ *
+ *  This libray is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ *  @file
+ *  Result structures.
+ *  @author Paul Bazin
+ *  @date 2010
+ *  @version 0.9-a2
+ *
+ *  This file contains the functions managing result structures, which
+ *  receive the outcome of a parse made by atropt_result instead of the
+ *  option structures.
+ */
+
+#include "stropt.h"
+#include "index.h"
+#include "arena.h"
+#include "result.h"
+
+void* smalloc(size_t);
+void* srealloc(void*, size_t);
+void sfree(void*);
+
+/* Fills a slot with what an option structure holds, its values being
+ * pointed to: they are copied before any other is appended. */
+static void default_slot(struct optslot* slot, const struct option* opt)
+{
+    size_t n=0;
+    if (opt->valuev)
+        while (opt->valuev[n])
+            n++;
+    slot->active=opt->active;
+    slot->value=opt->value;
+    slot->value_len = opt->value ? strlen(opt->value) : 0;
+    slot->valuev = n ? opt->valuev : NULL;
+    slot->valuec=n;
+    slot->valuecap=0;
+    slot->typedv = opt->typedc ? opt->typedv : NULL;
+    slot->typedc = slot->typedv ? opt->typedc : 0;
+    slot->typedcap=0;
+    slot->source=ATR_SRC_DEFAULT;
+}
+
+/** Creates a result structure.
+ *  A result structure holds one slot for each option structure of the
+ *  index, in the same order. After a parse made by atropt_result, the
+ *  slot tells whether the option is active, and which values it was
+ *  given, through the same members as the option structure: active,
+ *  value, value_len, valuev and valuec. A slot starts from what the
+ *  option structure holds before the parse, as atropt_index would, so
+ *  the defaults written there are kept: the table must then live as
+ *  long as the result structure. Unlike in the option structure,
+ *  valuev is NULL as long as the option has no value, given or by
+ *  default. The slots are only filled when a parse first writes them,
+ *  and are read through option_slot. All the slots are allocated
+ *  together, and the values copied by the parse are kept in one arena,
+ *  so the result structure is cheap to create for each parse. It can
+ *  also be kept and emptied by reset_option_result for the next parse.
+ *  You have to free it calling delete_option_result.
+ *  @param[in] idx The index the result structure will be used with.
+ *  @return A pointer to the newly allocated result structure, or NULL
+ *  on a failure.
+ */
+struct optres* new_option_result(const struct optidx* idx)
+{
+    struct optres* res = smalloc(sizeof *res + (sizeof *res->slot + 3*sizeof *res->touchedv + sizeof *res->genv)*idx->optc);
+    if (res)
+    {
+        res->optc=idx->optc;
+        res->optv=idx->optv;
+        res->slot=(struct optslot*) (res+1);
+        res->arena=NULL;
+        res->prev_arena=NULL;
+        res->touchedv=(size_t*) (res->slot+res->optc);
+        res->touchedc=0;
+        res->prev_touchedv=res->touchedv+res->optc;
+        res->prev_touchedc=0;
+        res->changedv=res->prev_touchedv+res->optc;
+        res->changedc=0;
+        /* The slots are out of date until a parse touches them. */
+        res->genv=(unsigned long*) (res->changedv+res->optc);
+        memset(res->genv, 0, (sizeof *res->genv)*res->optc);
+        res->gen=1;
+    }
+    return res;
+}
+
+/** Deletes safely a result structure.
+ *  This function frees a result structure created with
+ *  new_option_result, together with the values copied into it, and
+ *  assigns the pointer to NULL. If NULL is passed as pointer, no action
+ *  is performed.
+ *  @param[in,out] ptr The address of the pointer to the result
+ *  structure.
+ */
+void delete_option_result(struct optres** ptr)
+{
+    if (*ptr)
+    {
+        delete_arena(&(*ptr)->arena);
+        delete_arena(&(*ptr)->prev_arena);
+        sfree(*ptr);
+        *ptr=NULL;
+    }
+}
+
+/** Empties a result structure for the next parse.
+ *  This function takes the same time whatever the number of slots: it
+ *  only starts a new generation, each slot written by a previous one
+ *  being out of date. option_slot gives an out of date slot as the
+ *  defaults of its option structure, which is why the slots must be
+ *  read through it once the result structure was emptied. The memory
+ *  of the values is reused, but the values of the previous parse are
+ *  kept until the next call, for the next parse to tell which options
+ *  it changed. atropt_reparse calls this function itself.
+ *  @param[in,out] res A result structure created by new_option_result.
+ */
+void reset_option_result(struct optres* res)
+{
+    struct arena* arena=res->prev_arena;
+    size_t* touchedv=res->prev_touchedv;
+    res->prev_arena=res->arena;
+    res->arena=arena;
+    if (arena)
+        arena_reset(arena);
+    res->prev_touchedv=res->touchedv;
+    res->prev_touchedc=res->touchedc;
+    res->touchedv=touchedv;
+    res->touchedc=0;
+    res->changedc=0;
+    res->gen++;
+}
+
+/** Gives a slot of a result structure.
+ *  The result structure is only read, so that several threads can read
+ *  the same one at a time.
+ *  @param[in] res A result structure created by new_option_result.
+ *  @param[in] optn The index of the option structure in the table.
+ *  @param[out] dflt A slot filled with the defaults of the option
+ *  structure if the last parse did not write the slot of the result
+ *  structure.
+ *  @return A pointer to the slot, or to dflt.
+ */
+const struct optslot* option_slot(const struct optres* res, size_t optn, struct optslot* dflt)
+{
+    if (res->genv[optn] != res->gen)
+    {
+        default_slot(dflt, res->optv[optn]);
+        return dflt;
+    }
+    return res->slot+optn;
+}
+
+/* Tells where the state of an option comes from, without filling a
+ * slot with the defaults. */
+char slot_source(const struct optres* res, size_t optn)
+{
+    return res->genv[optn] == res->gen ? res->slot[optn].source : ATR_SRC_DEFAULT;
+}
+
+/* Makes a slot part of the current generation before it is written,
+ * remembering what the previous parse left in it. */
+struct optslot* touch_slot(struct optres* res, size_t optn)
+{
+    struct optslot* slot=res->slot+optn;
+    if (res->genv[optn] != res->gen)
+    {
+        if (res->genv[optn] && res->genv[optn]+1 == res->gen)
+        {
+            slot->prev_active=slot->active;
+            slot->prev_value=slot->value;
+            slot->prev_valuev=slot->valuev;
+            slot->prev_valuec=slot->valuec;
+        }
+        else
+        {
+            default_slot(slot, res->optv[optn]);
+            slot->prev_active=slot->active;
+            slot->prev_value=slot->value;
+            slot->prev_valuev=slot->valuev;
+            slot->prev_valuec=slot->valuec;
+        }
+        default_slot(slot, res->optv[optn]);
+        res->genv[optn]=res->gen;
+        res->touchedv[res->touchedc++]=optn;
+    }
+    return slot;
+}
+
+static char same_value(const char* a, const char* b)
+{
+    return a == b || (a && b && !strcmp(a, b));
+}
+
+static char slot_changed(const struct optslot* slot)
+{
+    size_t n;
+    if (slot->active != slot->prev_active || slot->valuec != slot->prev_valuec || !same_value(slot->value, slot->prev_value))
+        return 1;
+    for (n=0;n<slot->valuec;n++)
+        if (!same_value(slot->valuev[n], slot->prev_valuev[n]))
+            return 1;
+    return 0;
+}
+
+/* Fills changedv with the options written by this parse or by the
+ * previous one whose state differs, looking at these options only. */
+void list_changes(struct optres* res)
+{
+    size_t n;
+    res->changedc=0;
+    for (n=0;n<res->touchedc;n++)
+        if (slot_changed(res->slot+res->touchedv[n]))
+            res->changedv[res->changedc++]=res->touchedv[n];
+    for (n=0;n<res->prev_touchedc;n++)
+    {
+        size_t optn=res->prev_touchedv[n];
+        const struct optslot* slot=res->slot+optn;
+        struct optslot dflt;
+        if (res->genv[optn]+1 != res->gen)
+            continue;
+        /* Back to its defaults, compared with the previous parse. */
+        default_slot(&dflt, res->optv[optn]);
+        dflt.prev_active=slot->active;
+        dflt.prev_value=slot->value;
+        dflt.prev_valuev=slot->valuev;
+        dflt.prev_valuec=slot->valuec;
+        if (slot_changed(&dflt))
+            res->changedv[res->changedc++]=optn;
+    }
+}
@@ -0,0 +1,33 @@
+/*
+ *  Libstropt: an easy to use library about command-line options parsing
+ *  Copyright (C) 2010 Paul Bazin
+ *
+ *  This file is part of Libstrotp.
+ *
+ *  This libray is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ *  @file
+ *  Result structure internals.
+ *  Functions used by atropt.c to write the slots of a result structure
+ *  created by new_option_result(). They are not part of the API.
+ */
+
+#ifndef H_RESULT
+#define H_RESULT
+struct optslot* touch_slot(struct optres*, size_t);
+char slot_source(const struct optres*, size_t);
+void list_changes(struct optres*);
+#endif /* H_RESULT */
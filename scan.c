@@ -0,0 +1,296 @@
+/*
+ *  Libstropt: an easy to use library about command-line options parsing
+ *  Copyright (C) 2010 Paul Bazin
+ *
+ *  This file is part of Libstrotp.
+ *
+ *  This libray is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ *  @file
+ *  Byte scanning kernels.
+ *  @author Paul Bazin
+ *  @date 2010
+ *  @version 0.9-a2
+ *
+ *  This file contains the loops the parse spends its time in on long
+ *  arguments: finding the '=' of a long %option, comparing a name with
+ *  the one an index holds, and checking the characters of short
+ *  options. Each comes in a portable version, and, built by GCC or
+ *  Clang for x86, in SSE2 and AVX2 versions looking at 16 or 32 bytes
+ *  at once; the best the processor supports is picked on first use.
+ *  Defining STROPT_NO_SIMD keeps the portable versions only.
+ *
+ *  Finding the '=', the vector versions read whole aligned blocks,
+ *  which may begin before the argument and end after its terminating
+ *  NUL, but never cross a page. Comparing names shorter than a block,
+ *  they read a whole block when it does not cross a page either.
+ */
+
+#include <ctype.h>
+#include <pthread.h>
+#include "scan.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__)) && !defined(STROPT_NO_SIMD)
+#define SCAN_X86
+#include <emmintrin.h>
+#include <immintrin.h>
+/* The reads beyond the strings stay within their pages, but not within
+ * what the address sanitizer knows of. */
+#define SSE2_KERNEL __attribute__((target("sse2"), no_sanitize_address))
+#define AVX2_KERNEL __attribute__((target("avx2"), no_sanitize_address))
+#define PAGE 4096
+#endif
+
+struct scanops
+{
+    int level;
+    const char* (*eq)(const char*);
+    int (*same)(const char*, const char*, size_t);
+    size_t (*graph)(const char*, size_t);
+};
+
+static const char* eq_scalar(const char* s)
+{
+    while (*s != '\0' && *s != '=')
+        s++;
+    return s;
+}
+
+static int same_scalar(const char* a, const char* b, size_t n)
+{
+    size_t i;
+    for (i=0;i<n;i++)
+        if (a[i] != b[i])
+            return 0;
+    return 1;
+}
+
+/* A short %option character is graphic, and not a dash. */
+static char short_char(char c)
+{
+    return isgraph((unsigned char) c) && c != '-';
+}
+
+static size_t graph_scalar(const char* s, size_t n)
+{
+    size_t i=0;
+    while (i < n && short_char(s[i]))
+        i++;
+    return i;
+}
+
+static const struct scanops scalar_ops = {SCAN_SCALAR, eq_scalar, same_scalar, graph_scalar};
+
+#ifdef SCAN_X86
+/* Tells whether a block of size bytes from p stays within the page of
+ * p. */
+static int in_page(const char* p, size_t size)
+{
+    return ((size_t) p & (PAGE-1)) <= PAGE-size;
+}
+
+SSE2_KERNEL static const char* eq_sse2(const char* s)
+{
+    const __m128i eq=_mm_set1_epi8('=');
+    const __m128i nul=_mm_setzero_si128();
+    size_t skip=(size_t) s & 15;
+    const char* p=s-skip;
+    unsigned int mask;
+    __m128i v=_mm_load_si128((const __m128i*) p);
+    mask=(unsigned int) _mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(v, eq), _mm_cmpeq_epi8(v, nul))) >> skip;
+    if (mask)
+        return s+__builtin_ctz(mask);
+    for (;;)
+    {
+        p+=16;
+        v=_mm_load_si128((const __m128i*) p);
+        mask=(unsigned int) _mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(v, eq), _mm_cmpeq_epi8(v, nul)));
+        if (mask)
+            return p+__builtin_ctz(mask);
+    }
+}
+
+/* Compares 16 bytes, giving the mask of those differing. */
+SSE2_KERNEL static unsigned int diff16(const char* a, const char* b)
+{
+    __m128i va=_mm_loadu_si128((const __m128i*) a);
+    __m128i vb=_mm_loadu_si128((const __m128i*) b);
+    return (unsigned int) _mm_movemask_epi8(_mm_cmpeq_epi8(va, vb)) ^ 0xffffu;
+}
+
+SSE2_KERNEL static int same_sse2(const char* a, const char* b, size_t n)
+{
+    size_t i;
+    if (n < 16)
+    {
+        if (!in_page(a, 16) || !in_page(b, 16))
+            return same_scalar(a, b, n);
+        return !(diff16(a, b) & ((1u << n)-1));
+    }
+    for (i=0;i+16<n;i+=16)
+        if (diff16(a+i, b+i))
+            return 0;
+    return !diff16(a+n-16, b+n-16);
+}
+
+/* Gives the mask of the bytes of a block which are not printable ASCII
+ * characters other than the dash; the other bytes are left to
+ * isgraph. */
+SSE2_KERNEL static unsigned int not_short16(__m128i v)
+{
+    __m128i ok=_mm_and_si128(_mm_cmpgt_epi8(v, _mm_set1_epi8(' ')), _mm_cmplt_epi8(v, _mm_set1_epi8(127)));
+    ok=_mm_andnot_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('-')), ok);
+    return (unsigned int) _mm_movemask_epi8(ok) ^ 0xffffu;
+}
+
+SSE2_KERNEL static size_t graph_sse2(const char* s, size_t n)
+{
+    size_t i=0;
+    while (i+16 <= n)
+    {
+        unsigned int mask=not_short16(_mm_loadu_si128((const __m128i*) (s+i)));
+        if (!mask)
+            i+=16;
+        else
+        {
+            i+=__builtin_ctz(mask);
+            if (!short_char(s[i]))
+                return i;
+            i++;
+        }
+    }
+    return i+graph_scalar(s+i, n-i);
+}
+
+AVX2_KERNEL static const char* eq_avx2(const char* s)
+{
+    const __m256i eq=_mm256_set1_epi8('=');
+    const __m256i nul=_mm256_setzero_si256();
+    size_t skip=(size_t) s & 31;
+    const char* p=s-skip;
+    unsigned int mask;
+    __m256i v=_mm256_load_si256((const __m256i*) p);
+    mask=(unsigned int) _mm256_movemask_epi8(_mm256_or_si256(_mm256_cmpeq_epi8(v, eq), _mm256_cmpeq_epi8(v, nul))) >> skip;
+    if (mask)
+        return s+__builtin_ctz(mask);
+    for (;;)
+    {
+        p+=32;
+        v=_mm256_load_si256((const __m256i*) p);
+        mask=(unsigned int) _mm256_movemask_epi8(_mm256_or_si256(_mm256_cmpeq_epi8(v, eq), _mm256_cmpeq_epi8(v, nul)));
+        if (mask)
+            return p+__builtin_ctz(mask);
+    }
+}
+
+AVX2_KERNEL static int diff32(const char* a, const char* b)
+{
+    __m256i va=_mm256_loadu_si256((const __m256i*) a);
+    __m256i vb=_mm256_loadu_si256((const __m256i*) b);
+    return ~_mm256_movemask_epi8(_mm256_cmpeq_epi8(va, vb)) != 0;
+}
+
+AVX2_KERNEL static int same_avx2(const char* a, const char* b, size_t n)
+{
+    size_t i;
+    if (n < 32)
+        return n < 16 ? same_sse2(a, b, n) : !diff16(a, b) && !diff16(a+n-16, b+n-16);
+    for (i=0;i+32<n;i+=32)
+        if (diff32(a+i, b+i))
+            return 0;
+    return !diff32(a+n-32, b+n-32);
+}
+
+AVX2_KERNEL static size_t graph_avx2(const char* s, size_t n)
+{
+    size_t i=0;
+    while (i+32 <= n)
+    {
+        __m256i v=_mm256_loadu_si256((const __m256i*) (s+i));
+        __m256i ok=_mm256_and_si256(_mm256_cmpgt_epi8(v, _mm256_set1_epi8(' ')), _mm256_cmpgt_epi8(_mm256_set1_epi8(127), v));
+        unsigned int mask;
+        ok=_mm256_andnot_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('-')), ok);
+        mask=~(unsigned int) _mm256_movemask_epi8(ok);
+        if (!mask)
+            i+=32;
+        else
+        {
+            i+=__builtin_ctz(mask);
+            if (!short_char(s[i]))
+                return i;
+            i++;
+        }
+    }
+    return i+graph_sse2(s+i, n-i);
+}
+
+static const struct scanops sse2_ops = {SCAN_SSE2, eq_sse2, same_sse2, graph_sse2};
+static const struct scanops avx2_ops = {SCAN_AVX2, eq_avx2, same_avx2, graph_avx2};
+#endif
+
+static const struct scanops* ops=&scalar_ops;
+static const struct scanops* best=&scalar_ops;
+static pthread_once_t picked=PTHREAD_ONCE_INIT;
+
+static void pick_kernels(void)
+{
+#ifdef SCAN_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2"))
+        best=&avx2_ops;
+    else if (__builtin_cpu_supports("sse2"))
+        best=&sse2_ops;
+#endif
+    ops=best;
+}
+
+/* Finds the first '=' of a string, or its terminating NUL. */
+const char* scan_eq(const char* s)
+{
+    pthread_once(&picked, pick_kernels);
+    return ops->eq(s);
+}
+
+/* Tells whether the n first bytes of two strings are the same. */
+int scan_same(const char* a, const char* b, size_t n)
+{
+    pthread_once(&picked, pick_kernels);
+    return ops->same(a, b, n);
+}
+
+/* Gives the number of leading characters of s, of length n, which can
+ * be short options. */
+size_t scan_graph(const char* s, size_t n)
+{
+    pthread_once(&picked, pick_kernels);
+    return ops->graph(s, n);
+}
+
+/* Makes the kernels of a level be used, or the best the processor
+ * supports under it, and gives the level used. It lets the benchmark
+ * compare them, and must not be called during a parse. */
+int set_scan_level(int level)
+{
+    pthread_once(&picked, pick_kernels);
+    ops=best;
+#ifdef SCAN_X86
+    if (level < ops->level && level >= SCAN_SSE2)
+        ops=&sse2_ops;
+#endif
+    if (level < ops->level)
+        ops=&scalar_ops;
+    return ops->level;
+}
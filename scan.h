@@ -0,0 +1,46 @@
+/*
+ *  Libstropt: an easy to use library about command-line options parsing
+ *  Copyright (C) 2010 Paul Bazin
+ *
+ *  This file is part of Libstrotp.
+ *
+ *  This libray is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ *  @file
+ *  Byte scanning internals.
+ *  The kernels the parse scans arguments and names with, picked at run
+ *  time among a portable version and SSE2 and AVX2 ones. They are not
+ *  part of the API.
+ */
+
+#ifndef H_SCAN
+#define H_SCAN
+
+#include <stddef.h>
+
+enum scanlevel
+{
+    SCAN_SCALAR,
+    SCAN_SSE2,
+    SCAN_AVX2
+};
+
+const char* scan_eq(const char*);
+int scan_same(const char*, const char*, size_t);
+size_t scan_graph(const char*, size_t);
+int set_scan_level(int);
+
+#endif /* H_SCAN */
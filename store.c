@@ -0,0 +1,244 @@
+/*
+ *  Libstropt: an easy to use library about command-line options parsing
+ *  Copyright (C) 2010 Paul Bazin
+ *
+ *  This file is part of Libstrotp.
+ *
+ *  This libray is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ *  @file
+ *  Value store.
+ *  @author Paul Bazin
+ *  @date 2010
+ *  @version 0.9-a2
+ *
+ *  This file contains the store of the values of an option structure
+ *  taking several values. The values copied are packed one after the
+ *  other into a single buffer, growing geometrically, and located by
+ *  their offsets, so that repeating an option costs no allocation of
+ *  its own; the values borrowed from the arguments or copied into an
+ *  arena are only pointed to. The valuev array is kept up to date as a
+ *  view of the store, its pointers being moved with the buffer.
+ */
+
+#include "stropt.h"
+#include "store.h"
+
+void* smalloc(size_t);
+void* srealloc(void*, size_t);
+void sfree(void*);
+
+static void count_store(struct atrstats* stats, char re, size_t size)
+{
+    if (stats)
+    {
+        if (re)
+            stats->reallocs++;
+        else
+            stats->allocs++;
+        stats->bytes+=size;
+    }
+}
+
+/* Tells whether the store of an option still describes its valuev,
+ * which the user may have replaced. */
+static char current_store(const struct option* opt)
+{
+    return opt->values && opt->values->view && opt->values->view == opt->valuev;
+}
+
+/* Gives the store of an option, created from the values its valuev
+ * already holds, which are then freed one by one. A store whose valuev
+ * was replaced is emptied, its packed values being lost. */
+static struct valstore* option_store(struct option* opt, struct atrstats* stats)
+{
+    struct valstore* s=opt->values;
+    size_t n=0;
+    size_t cap;
+    char** view;
+    struct valref* refv;
+    if (current_store(opt))
+        return s;
+    if (!s)
+    {
+        count_store(stats, 0, sizeof *s);
+        s = smalloc(sizeof *s);
+        if (!s)
+            return NULL;
+        s->refv=NULL;
+        s->buf=NULL;
+        s->typedcap=opt->typedc;
+        opt->values=s;
+    }
+    sfree(s->refv);
+    sfree(s->buf);
+    s->count=0;
+    s->cap=0;
+    s->refv=NULL;
+    s->buf=NULL;
+    s->buflen=0;
+    s->bufsize=0;
+    s->view=NULL;
+    if (opt->valuev)
+        while (opt->valuev[n])
+            n++;
+    for (cap=4;cap < n+1;cap*=2);
+    count_store(stats, 1, (sizeof *view)*cap);
+    view = srealloc(opt->valuev, (sizeof *view)*cap);
+    if (!view)
+        return NULL;
+    opt->valuev=view;
+    count_store(stats, 0, (sizeof *refv)*cap);
+    refv = smalloc((sizeof *refv)*cap);
+    if (!refv)
+        return NULL;
+    view[n]=NULL;
+    s->view=view;
+    s->refv=refv;
+    s->cap=cap;
+    for (s->count=0;s->count<n;s->count++)
+    {
+        refv[s->count].off=VAL_OWN;
+        refv[s->count].len=strlen(view[s->count]);
+    }
+    return s;
+}
+
+/* Makes room for len more bytes in the packed buffer, moving the
+ * values held there with it. */
+static int reserve_buffer(struct valstore* s, size_t len, struct atrstats* stats)
+{
+    size_t size=s->bufsize ? 2*s->bufsize : 256;
+    size_t n;
+    char* buf;
+    if (s->buflen+len <= s->bufsize)
+        return 0;
+    if (size < s->buflen+len)
+        size=s->buflen+len;
+    count_store(stats, 1, size);
+    buf = srealloc(s->buf, size);
+    if (!buf)
+        return -1;
+    if (buf != s->buf)
+        for (n=0;n<s->count;n++)
+            if (s->refv[n].off < VAL_OWN)
+                s->view[n]=buf+s->refv[n].off;
+    s->buf=buf;
+    s->bufsize=size;
+    return 0;
+}
+
+/* Appends a value to an option taking several values: copied into the
+ * packed buffer if pack is set, pointed to otherwise. */
+int store_value(struct option* opt, const char* val, char pack, struct atrstats* stats)
+{
+    struct valstore* s=option_store(opt, stats);
+    size_t len=strlen(val);
+    if (!s)
+        return -1;
+    if (s->count+2 > s->cap)
+    {
+        char** view;
+        struct valref* refv;
+        count_store(stats, 1, (sizeof *view)*2*s->cap);
+        view = srealloc(s->view, (sizeof *view)*2*s->cap);
+        if (!view)
+            return -1;
+        s->view=view;
+        opt->valuev=view;
+        count_store(stats, 1, (sizeof *refv)*2*s->cap);
+        refv = srealloc(s->refv, (sizeof *refv)*2*s->cap);
+        if (!refv)
+            return -1;
+        s->refv=refv;
+        s->cap*=2;
+    }
+    if (pack)
+    {
+        if (reserve_buffer(s, len+1, stats))
+            return -1;
+        memcpy(s->buf+s->buflen, val, len+1);
+        s->refv[s->count].off=s->buflen;
+        s->view[s->count]=s->buf+s->buflen;
+        s->buflen+=len+1;
+    }
+    else
+    {
+        s->refv[s->count].off=VAL_EXT;
+        s->view[s->count]=(char*) val;
+    }
+    s->refv[s->count].len=len;
+    s->view[++s->count]=NULL;
+    opt->valuec=s->count;
+    return 0;
+}
+
+/* Frees the values of an option, its valuev and its store. */
+void free_values(struct option* opt)
+{
+    size_t n;
+    if (current_store(opt))
+    {
+        for (n=0;n<opt->values->count;n++)
+            if (opt->values->refv[n].off == VAL_OWN)
+                sfree(opt->valuev[n]);
+    }
+    else if (opt->valuev)
+        for (n=0;opt->valuev[n];n++)
+            sfree(opt->valuev[n]);
+    sfree(opt->valuev);
+    opt->valuev=NULL;
+    if (opt->values)
+    {
+        sfree(opt->values->refv);
+        sfree(opt->values->buf);
+        sfree(opt->values);
+        opt->values=NULL;
+    }
+}
+
+/** Gives the number of values of an option structure.
+ *  Unlike valuec, the count covers the default values written into
+ *  valuev as well as the values given by a parse, and does not wrap.
+ *  It is kept by the parse, so that it costs nothing, as long as
+ *  valuev is not replaced.
+ *  @param[in] opt The option structure.
+ *  @return The number of values in valuev.
+ */
+size_t option_value_count(const struct option* opt)
+{
+    size_t n=0;
+    if (current_store(opt))
+        return opt->values->count;
+    if (opt->valuev)
+        while (opt->valuev[n])
+            n++;
+    return n;
+}
+
+/** Gives a value of an option structure and its length.
+ *  @param[in] opt The option structure.
+ *  @param[in] n The position of the value in valuev, less than
+ *  option_value_count().
+ *  @param[out] len Where to write the length of the value, or NULL.
+ *  @return The value.
+ */
+const char* option_value(const struct option* opt, size_t n, size_t* len)
+{
+    if (len)
+        *len = current_store(opt) ? opt->values->refv[n].len : strlen(opt->valuev[n]);
+    return opt->valuev[n];
+}
@@ -0,0 +1,58 @@
+/*
+ *  Libstropt: an easy to use library about command-line options parsing
+ *  Copyright (C) 2010 Paul Bazin
+ *
+ *  This file is part of Libstrotp.
+ *
+ *  This libray is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ *  @file
+ *  Value store internals.
+ *  The store behind the valuev member of an option structure taking
+ *  several values, and the functions atropt.c and user.c fill and free
+ *  it with. They are not part of the API.
+ */
+
+#ifndef H_STORE
+#define H_STORE
+
+/* Offsets of the values not held in the packed buffer: pointing into
+ * the arguments or an arena, or allocated one by one, as the defaults
+ * written by the user are. */
+#define VAL_EXT ((size_t) -1)
+#define VAL_OWN ((size_t) -2)
+
+struct valref
+{
+    size_t off;
+    size_t len;
+};
+struct valstore
+{
+    size_t count;
+    size_t cap;
+    struct valref* refv;
+    char* buf;
+    size_t buflen;
+    size_t bufsize;
+    char** view;
+    size_t typedcap;
+};
+
+int store_value(struct option*, const char*, char, struct atrstats*);
+void free_values(struct option*);
+
+#endif /* H_STORE */
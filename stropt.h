@@ -68,6 +68,20 @@
  *  to give you some indication. If no value for the option involved is
  *  passed trhough the command-line, valuec is not updated.
  *
+ *  The values an option structure takes several of are packed into a
+ *  single buffer, so that an option repeated many times costs a few
+ *  allocations in all; valuev points into it, and stays valid until
+ *  the option structure is deleted. option_value_count() and
+ *  option_value() give their number and lengths without going through
+ *  valuev. Replacing valuev after a parse drops the values the parse
+ *  packed.
+ *
+ *  The values are copied into the option structures, unless you set
+ *  the borrow member of an option structure: value and valuev then
+ *  point into the command-line arguments themselves, value_len giving
+ *  the length of value. This saves a copy of each value, but the
+ *  arguments must not be modified as long as you use the values.
+ *
  *  Any value passed through a parameter is ignored for each option
  *  which is unactivated by this parameter, as well as that value is
  *  actually assignated to any options which is activated by this
@@ -83,7 +97,106 @@
  *  only unactivator.
  *
  *  To launch the comparison of the command-line arguments against the
- *  options you declared, you should use the atropt() call.
+ *  options you declared, you should use the atropt() call. If you parse
+ *  several command lines against the same options, you can compile the
+ *  table once with new_option_index(), and then use atropt_index()
+ *  instead: each short %option character is then resolved by a single
+ *  lookup. The index must be freed with delete_option_index().
+ *
+ *  atropt_conf() also takes an atrconf structure, which changes the way
+ *  the parse is performed. For instance, it can take all the memory
+ *  the parse needs from an arena created by new_arena(), so that one
+ *  delete_arena() call frees everything. It can also expand '@file'
+ *  arguments into the tokens of the named response file.
+ *
+ *  An index is never written by a parse. If atropt_result() is given a
+ *  result structure created by new_option_result(), the parse does not
+ *  write the option structures either: the outcome goes into the result
+ *  structure. Any number of threads can then parse against the same
+ *  index at the same time, each one with its own result structure.
+ *  atropt_batch() does so for a whole array of argument vectors, on a
+ *  pool of threads.
+ *
+ *  A program parsing again and again, such as a daemon reloading its
+ *  settings on SIGHUP, can keep its rtrn and result structures:
+ *  atropt_reparse() empties them without freeing their buffers, and
+ *  lists in changedv[] the options which differ from the previous
+ *  parse. Read the slots through option_slot() then, as emptying a
+ *  result structure only marks its slots as out of date.
+ *
+ *  Instead of having the whole parse stored, you can also pull its
+ *  events one at a time, as getopt() does: init_iterator() starts the
+ *  parse, each next_event() call gives whether an option is activated
+ *  or unactivated, a positional argument or an error, and
+ *  end_iterator() ends it.
+ *
+ *  An option taking a value can also declare its value_type: a signed
+ *  or unsigned integer, a double, a boolean, a size with an optional
+ *  K, M, G or T suffix, a duration with an optional unit from ns to d,
+ *  or one of the names of its value_enum array. Each value is then
+ *  decoded by the parse, whatever the locale, into typedv[], holding
+ *  typedc values; an invalid value is reported in errsv instead.
+ *
+ *  Settings can also come from a configuration file and from the
+ *  environment: give atrconf the name of a file of "name=value" lines,
+ *  and a prefix such that the variable PREFIX_LOG_LEVEL sets the long
+ *  %option log-level. Each name is looked up as a long %option, the
+ *  values staying in the mapped file and the environment. The command
+ *  line wins over the environment, which wins over the file, and the
+ *  source member of each option tells where it was last set from.
+ *
+ *  With the suggest member of atrconf set, each "no option matched"
+ *  error comes with the closest long %option name, if any is close
+ *  enough, in errshint; suggest_options() gives all of them.
+ *
+ *  A program can also declare its options statically, with no call and
+ *  no allocation at all: STATIC_OPTION() initializes an option
+ *  structure from its short %option strings, its NULL terminated
+ *  arrays of long %option names, any of them possibly NULL, and its
+ *  takes_value member. Such an option structure must never be given to
+ *  set_short_options(), new_long_option() or delete_option(). The index
+ *  of a static table is built on the first call to declared_index(),
+ *  then reused. If it cannot be built, declared_index() gives NULL,
+ *  which the parsing functions take as a failure.
+ *  @code
+ *  static const char* verbose_names[] = {"verbose", NULL};
+ *  static struct option verbose = STATIC_OPTION("v", "q", verbose_names, NULL, 0);
+ *  static struct option* optv[] = {&verbose, NULL};
+ *  static struct optdecl decl = STATIC_INDEX(optv);
+ *  ...
+ *  ret = atropt_index(argc, argv, declared_index(&decl));
+ *  @endcode
+ *
+ *  A program made of subcommands, as git is, gives atropt_command() its
+ *  global options and an array of subcommands, each declared with
+ *  STATIC_COMMAND() from its name and either its table or a function
+ *  building it. The global options are parsed up to the first
+ *  positional argument naming a subcommand; only the table of this
+ *  subcommand is then built and compiled, together with the global
+ *  options, which stay recognized after the subcommand name.
+ *
+ *  Shell completion goes through a table compiled from an index by
+ *  new_completion_table(): complete_line() gives the options and values
+ *  the word under the cursor can become, and whether a value is
+ *  expected. The table can be written to a cache file with
+ *  write_completion_table() and mapped back with
+ *  load_completion_table(), without building the options at all.
+ *
+ *  To see what a parse costs, give the atrconf structure an atrstats
+ *  structure: the parse fills it with the number of arguments scanned,
+ *  lookups, string comparisons, allocations and errors. An atrhooks
+ *  structure gets functions called, with a monotonic timestamp, when
+ *  the parse begins, at each argument and when it ends. Both are left
+ *  NULL by default, which costs nothing.
+ *
+ *  A program written for getopt_long() can keep its tables and its
+ *  loop: stropt_getopt.h declares atropt_getopt_long() and
+ *  atropt_getopt_long_only(), which behave as the GNU functions but
+ *  look the options up in an index compiled once per table.
+ *
+ *  The library allocates its memory with malloc() unless you give it
+ *  your own allocator with set_allocator(). set_debug_allocator() makes
+ *  allocations fail at random, to test how your program copes.
  *
  *  As soon as you no longer need the rtrn structure returned by
  *  atropt(), you must free it using delete_return(). As soon as you no
@@ -92,6 +205,12 @@
  *  pointers using new_option_table(), you must use delete_option_table
  *  instead; which will free all the option strucutre together.
  *
+ *  A C++ program can include stropt.hpp instead: it declares the
+ *  options as constexpr arrays checked at compile time, and gives
+ *  parsers and results freeing themselves, whose values are
+ *  std::string_view into the arguments. The index is still compiled at
+ *  run time, when the parser is built.
+ *
  *  We hope you will enjoy Libstropt.
  */
 
@@ -101,6 +220,36 @@
 #include <string.h>
 #include <ctype.h>
 
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+enum atrtype
+{
+    ATR_STRING,
+    ATR_INT,
+    ATR_UINT,
+    ATR_DOUBLE,
+    ATR_BOOL,
+    ATR_SIZE,
+    ATR_DURATION,
+    ATR_ENUM
+};
+enum atrsource
+{
+    ATR_SRC_DEFAULT,
+    ATR_SRC_FILE,
+    ATR_SRC_ENV,
+    ATR_SRC_ARGV
+};
+union atrvalue
+{
+    long i;
+    unsigned long u;
+    double d;
+    char b;
+    int e;
+};
 struct option
 {
     char active;
@@ -111,25 +260,241 @@ struct option
     char takes_value;
     char* value;
     char** valuev;
-    int valuec;
+    size_t valuec;
+    char value_ext;
+    struct valstore* values;
+    char borrow;
+    size_t value_len;
+    char value_type;
+    const char* const* value_enum;
+    union atrvalue* typedv;
+    size_t typedc;
+    char source;
+};
+#define STATIC_TYPED_OPTION(short_act, short_unact, long_act, long_unact, takes_value, value_type, value_enum) \
+    {0, (char*) (short_act), (long_act), (char*) (short_unact), (long_unact), \
+     (takes_value), NULL, NULL, 0, 0, NULL, 0, 0, (value_type), (value_enum), NULL, 0, ATR_SRC_DEFAULT}
+#define STATIC_OPTION(short_act, short_unact, long_act, long_unact, takes_value) \
+    STATIC_TYPED_OPTION(short_act, short_unact, long_act, long_unact, takes_value, ATR_STRING, NULL)
+#define STATIC_INDEX(optv) {(optv), NULL}
+#define STATIC_COMMAND(name, optv, build) {(name), (optv), (build), NULL, NULL, 0}
+struct argpos
+{
+    int argn;
+    const char* file;
+    size_t offset;
 };
 struct rtrn
 {
-    int argsc;
+    size_t argsc;
     char** argsv;
-    int errsc;
+    size_t errsc;
     const char** errsv;
     int* errsarg;
+    size_t argscap;
+    size_t errscap;
+    struct arena* arena;
+    char arena_owned;
+    struct argpos* argspos;
+    struct argpos* errspos;
+    struct respfile* files;
+    const char** errshint;
+    struct respfile* prev_files;
+};
+struct optslot
+{
+    char active;
+    char* value;
+    size_t value_len;
+    char** valuev;
+    size_t valuec;
+    size_t valuecap;
+    union atrvalue* typedv;
+    size_t typedc;
+    size_t typedcap;
+    char source;
+    char prev_active;
+    char* prev_value;
+    char** prev_valuev;
+    size_t prev_valuec;
+};
+struct optres
+{
+    size_t optc;
+    struct option** optv;
+    struct optslot* slot;
+    struct arena* arena;
+    struct arena* prev_arena;
+    unsigned long* genv;
+    unsigned long gen;
+    size_t* touchedv;
+    size_t touchedc;
+    size_t* prev_touchedv;
+    size_t prev_touchedc;
+    size_t* changedv;
+    size_t changedc;
+};
+struct atrtime
+{
+    long sec;
+    long nsec;
+};
+struct atrstats
+{
+    size_t args;
+    size_t short_lookups;
+    size_t long_lookups;
+    size_t compares;
+    size_t allocs;
+    size_t reallocs;
+    size_t bytes;
+    size_t errors;
+};
+struct atrhooks
+{
+    void (*begin)(void*,const struct atrtime*);
+    void (*arg)(void*,const char*,const struct argpos*,const struct atrtime*);
+    void (*end)(void*,const struct atrstats*,const struct atrtime*);
+    void* ctx;
+};
+struct atrconf
+{
+    struct arena* arena;
+    char use_arena;
+    char borrow;
+    int respfile_depth;
+    struct atrstats* stats;
+    const struct atrhooks* hooks;
+    const char* config_file;
+    const char* env_prefix;
+    char suggest;
+};
+struct atralloc
+{
+    void* (*alloc)(void*,size_t);
+    void* (*resize)(void*,void*,size_t);
+    void (*release)(void*,void*);
+    void* ctx;
+};
+struct valstore;
+struct optidx;
+struct arena;
+struct respfile;
+struct optdecl
+{
+    struct option** optv;
+    struct optidx* idx;
+};
+struct atrcmd
+{
+    const char* name;
+    struct option** optv;
+    struct option** (*build)(const char*);
+    struct option** allv;
+    struct optidx* idx;
+    char built;
+};
+struct atrcomptab;
+struct atrcomp
+{
+    size_t candc;
+    char** candv;
+    char value;
+};
+enum atrevtype
+{
+    ATR_ACTIVATED,
+    ATR_UNACTIVATED,
+    ATR_POSITIONAL,
+    ATR_ERROR
+};
+struct atrevent
+{
+    enum atrevtype type;
+    size_t opt;
+    const char* value;
+    size_t value_len;
+    const char* error;
+    struct argpos pos;
+    union atrvalue typed;
+    const char* hint;
+};
+struct atrit
+{
+    const struct optidx* idx;
+    const char* const* argv;
+    int argc;
+    int argn;
+    char skip;
+    char failed;
+    const char* tok;
+    struct argpos tokpos;
+    struct argpos pos;
+    struct respfile* top;
+    struct respfile* files;
+    int depth;
+    int maxdepth;
+    const char* err;
+    struct argpos errpos;
+    const char* arg;
+    char is_long;
+    size_t s_flag;
+    size_t entn;
+    size_t entend;
+    char jump;
+    int eq;
+    char nomatch;
+    struct atrstats* stats;
+    const struct atrhooks* hooks;
+    char ended;
+    char suggest;
+    const char* hint;
+    const char* hint_arg;
 };
 
 struct option* new_option(void);
 int new_long_option(struct option*,char,const char*);
 int set_short_options(struct option*,const char*,const char*);
 void delete_option(struct option**);
-struct option** new_option_table(int);
+size_t option_value_count(const struct option*);
+const char* option_value(const struct option*,size_t,size_t*);
+struct option** new_option_table(size_t);
 void delete_option_table(struct option***);
 void delete_return(struct rtrn**);
+struct optidx* new_option_index(struct option**);
+void delete_option_index(struct optidx**);
+const struct optidx* declared_index(struct optdecl*);
+const struct optidx* command_index(struct atrcmd*,struct option**);
+void delete_command_indexes(struct atrcmd*);
+size_t suggest_options(const struct optidx*,const char*,size_t,const char**,size_t);
 struct rtrn* atropt(int,char**,struct option**);
+struct rtrn* atropt_index(int,char**,const struct optidx*);
+struct rtrn* atropt_conf(int,const char* const*,const struct optidx*,const struct atrconf*);
+struct optres* new_option_result(const struct optidx*);
+void delete_option_result(struct optres**);
+void reset_option_result(struct optres*);
+const struct optslot* option_slot(const struct optres*, size_t, struct optslot*);
+struct rtrn* atropt_result(int,const char* const*,const struct optidx*,struct optres*,const struct atrconf*);
+int atropt_reparse(struct rtrn*,int,const char* const*,const struct optidx*,struct optres*,const struct atrconf*);
+struct rtrn* atropt_command(int,const char* const*,struct optdecl*,struct atrcmd*,const struct atrconf*,struct atrcmd**);
+struct atrcomptab* new_completion_table(const struct optidx*);
+struct atrcomptab* load_completion_table(const char*);
+int write_completion_table(const struct atrcomptab*,const char*);
+void delete_completion_table(struct atrcomptab**);
+struct atrcomp* complete_line(const struct atrcomptab*,const char*,size_t);
+void delete_completion(struct atrcomp**);
+int atropt_batch(size_t,const int*,const char* const* const*,const struct optidx*,struct optres**,struct rtrn**,const struct atrconf*,int);
+void init_iterator(struct atrit*,int,const char* const*,const struct optidx*,const struct atrconf*);
+int next_event(struct atrit*,struct atrevent*);
+void end_iterator(struct atrit*);
+struct arena* new_arena(size_t);
+void delete_arena(struct arena**);
+void set_allocator(const struct atralloc*);
+void set_debug_allocator(int);
+
+#ifdef __cplusplus
+}
+#endif
 
 #endif /* H_STROPT */
 
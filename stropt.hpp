@@ -0,0 +1,449 @@
+/*
+ *  Libstropt: an easy to use library about command-line options parsing
+ *  Copyright (C) 2010 Paul Bazin
+ *
+ *  This file is part of Libstrotp.
+ *
+ *  This libray is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ *  @file
+ *  C++ interface.
+ *  @author Paul Bazin
+ *  @date 2010
+ *  @version 0.9-a2
+ *
+ *  This header wraps Libstropt for C++17 and later programs, without
+ *  any code to build. The options are declared as a constexpr array of
+ *  stropt::opt. Only the checks are done at compile time:
+ *  stropt::valid() rejects bad declarations, and stropt::find() gives
+ *  the position of a name.
+ *  @code
+ *  constexpr stropt::opt specs[] = {
+ *      {"v", "", "verbose"},
+ *      {"o", "", "output", nullptr, 1},
+ *  };
+ *  static_assert(stropt::valid(specs));
+ *  constexpr std::size_t output = stropt::find(specs, "output");
+ *
+ *  stropt::parser p(specs);
+ *  stropt::result r = p.parse(argc, argv);
+ *  std::string_view file = r.value(output);
+ *  @endcode
+ *
+ *  A parser owns the option structures and their index. These are
+ *  allocated and compiled at run time, once, when the parser is built.
+ *  A result owns the result and rtrn structures of a parse. Both free
+ *  them when destroyed, and can be moved but not copied. The values
+ *  are borrowed: they are std::string_view into the arguments, which
+ *  must outlive the result. The first parse into a result allocates
+ *  its structures. Parsing again into the same result reuses them, so
+ *  that a parse soon allocates nothing. As the index is only read, a
+ *  parser can fill several results at the same time. The constructors
+ *  and parse throw std::bad_alloc when the memory lacks. The
+ *  constructors of parser throw std::invalid_argument for options
+ *  which stropt::valid() or the library rejects.
+ */
+
+#ifndef H_STROPT_HPP
+#define H_STROPT_HPP
+
+#include <cstddef>
+#include <iterator>
+#include <new>
+#include <stdexcept>
+#include <string_view>
+#include <utility>
+#if __cplusplus >= 202002L && __has_include(<span>)
+#include <span>
+#endif
+#include "stropt.h"
+
+namespace stropt
+{
+
+/** Declaration of an option.
+ *  The short members hold the characters activating and unactivating
+ *  the option, the long members a name activating it and one
+ *  unactivating it, any of them being possibly NULL. takes_value is 0
+ *  for an option taking no value, 1 for one value, 2 for several;
+ *  value_type and value_enum are those of the option structure.
+ */
+struct opt
+{
+    const char* short_act = nullptr;
+    const char* short_unact = nullptr;
+    const char* long_act = nullptr;
+    const char* long_unact = nullptr;
+    char takes_value = 0;
+    char value_type = ATR_STRING;
+    const char* const* value_enum = nullptr;
+};
+
+#if __cplusplus >= 202002L && __has_include(<span>)
+template<class T> using span = std::span<T>;
+#else
+/** Contiguous sequence, as std::span, which C++17 lacks. */
+template<class T> class span
+{
+public:
+    constexpr span() noexcept = default;
+    constexpr span(T* data, std::size_t size) noexcept : data_(data), size_(size) {}
+    constexpr T* data() const noexcept { return data_; }
+    constexpr std::size_t size() const noexcept { return size_; }
+    constexpr bool empty() const noexcept { return !size_; }
+    constexpr T& operator[](std::size_t n) const noexcept { return data_[n]; }
+    constexpr T* begin() const noexcept { return data_; }
+    constexpr T* end() const noexcept { return data_+size_; }
+private:
+    T* data_ = nullptr;
+    std::size_t size_ = 0;
+};
+#endif
+
+/** Values of an option taking several, seen as std::string_view. */
+class string_list
+{
+public:
+    class iterator
+    {
+    public:
+        using iterator_category = std::random_access_iterator_tag;
+        using value_type = std::string_view;
+        using difference_type = std::ptrdiff_t;
+        using pointer = void;
+        using reference = std::string_view;
+        constexpr iterator() noexcept = default;
+        constexpr explicit iterator(char* const* p) noexcept : p_(p) {}
+        constexpr std::string_view operator*() const noexcept { return *p_; }
+        constexpr std::string_view operator[](difference_type n) const noexcept { return p_[n]; }
+        constexpr iterator& operator++() noexcept { ++p_; return *this; }
+        constexpr iterator operator++(int) noexcept { return iterator(p_++); }
+        constexpr iterator& operator--() noexcept { --p_; return *this; }
+        constexpr iterator operator--(int) noexcept { return iterator(p_--); }
+        constexpr iterator& operator+=(difference_type n) noexcept { p_+=n; return *this; }
+        constexpr iterator& operator-=(difference_type n) noexcept { p_-=n; return *this; }
+        constexpr iterator operator+(difference_type n) const noexcept { return iterator(p_+n); }
+        constexpr iterator operator-(difference_type n) const noexcept { return iterator(p_-n); }
+        constexpr difference_type operator-(iterator o) const noexcept { return p_-o.p_; }
+        constexpr bool operator==(iterator o) const noexcept { return p_ == o.p_; }
+        constexpr bool operator!=(iterator o) const noexcept { return p_ != o.p_; }
+        constexpr bool operator<(iterator o) const noexcept { return p_ < o.p_; }
+    private:
+        char* const* p_ = nullptr;
+    };
+    constexpr string_list() noexcept = default;
+    constexpr string_list(char* const* data, std::size_t size) noexcept : data_(data), size_(size) {}
+    constexpr std::size_t size() const noexcept { return size_; }
+    constexpr bool empty() const noexcept { return !size_; }
+    constexpr std::string_view operator[](std::size_t n) const noexcept { return data_[n]; }
+    constexpr iterator begin() const noexcept { return iterator(data_); }
+    constexpr iterator end() const noexcept { return iterator(data_+size_); }
+private:
+    char* const* data_ = nullptr;
+    std::size_t size_ = 0;
+};
+
+namespace detail
+{
+/* A short option character is printable ASCII, and not a dash; the
+ * library also accepts what isgraph accepts in the current locale. */
+constexpr bool short_chars(const char* s) noexcept
+{
+    for (;s && *s;s++)
+        if (*s <= ' ' || *s >= 127 || *s == '-')
+            return false;
+    return true;
+}
+
+constexpr bool long_name(const char* s) noexcept
+{
+    if (!s)
+        return true;
+    if (!*s)
+        return false;
+    for (;*s;s++)
+        if (*s == '=')
+            return false;
+    return true;
+}
+
+constexpr bool has_char(const char* s, char c) noexcept
+{
+    for (;s && *s;s++)
+        if (*s == c)
+            return true;
+    return false;
+}
+}
+
+/** Tells whether an option declaration is accepted by the library. */
+constexpr bool valid(const opt& o) noexcept
+{
+    return detail::short_chars(o.short_act) && detail::short_chars(o.short_unact)
+        && detail::long_name(o.long_act) && detail::long_name(o.long_unact)
+        && o.takes_value >= 0 && o.takes_value <= 2
+        && (o.value_type == ATR_STRING || o.takes_value);
+}
+
+/** Tells whether all the declarations of an array are accepted by the
+ *  library, to be checked by a static_assert.
+ */
+template<std::size_t N> constexpr bool valid(const opt (&specs)[N]) noexcept
+{
+    for (std::size_t n=0;n<N;n++)
+        if (!valid(specs[n]))
+            return false;
+    return true;
+}
+
+/** Gives the position in an array of the first option a name belongs
+ *  to, a long name or a short character, activating or unactivating
+ *  it, or N if none does. Evaluated at compile time, it names the
+ *  options the result is read with.
+ */
+template<std::size_t N> constexpr std::size_t find(const opt (&specs)[N], std::string_view name) noexcept
+{
+    for (std::size_t n=0;n<N;n++)
+    {
+        const opt& o=specs[n];
+        if ((o.long_act && name == o.long_act) || (o.long_unact && name == o.long_unact))
+            return n;
+        if (name.size() == 1 && (detail::has_char(o.short_act, name[0]) || detail::has_char(o.short_unact, name[0])))
+            return n;
+    }
+    return N;
+}
+
+class parser;
+
+/** Result of a parse.
+ *  The options are read by their position in the array the parser was
+ *  built from. A default constructed result is empty, and is filled by
+ *  parser::parse.
+ */
+class result
+{
+public:
+    result() noexcept = default;
+    result(const result&) = delete;
+    result& operator=(const result&) = delete;
+    result(result&& o) noexcept : idx_(o.idx_), res_(o.res_), ret_(o.ret_)
+    {
+        o.idx_=nullptr;
+        o.res_=nullptr;
+        o.ret_=nullptr;
+    }
+    result& operator=(result&& o) noexcept
+    {
+        if (this != &o)
+        {
+            clear();
+            std::swap(idx_, o.idx_);
+            std::swap(res_, o.res_);
+            std::swap(ret_, o.ret_);
+        }
+        return *this;
+    }
+    ~result() { clear(); }
+
+    /** Tells whether the parse went without error. */
+    bool ok() const noexcept { return ret_ && !ret_->errsc; }
+    /** Tells whether an option is active. */
+    bool active(std::size_t n) const noexcept { optslot d; return slot(n, d)->active; }
+    /** Tells where the state of an option comes from, an atrsource. */
+    char source(std::size_t n) const noexcept { optslot d; return slot(n, d)->source; }
+    /** Gives the value of an option taking one, empty if none. */
+    std::string_view value(std::size_t n) const noexcept
+    {
+        optslot d;
+        const optslot* s=slot(n, d);
+        return s->value ? std::string_view(s->value, s->value_len) : std::string_view();
+    }
+    /** Gives the values of an option taking several. */
+    string_list values(std::size_t n) const noexcept
+    {
+        optslot d;
+        const optslot* s=slot(n, d);
+        return string_list(s->valuev, s->valuec);
+    }
+    /** Gives the decoded values of an option declaring a value type. */
+    span<const atrvalue> typed(std::size_t n) const noexcept
+    {
+        optslot d;
+        const optslot* s=slot(n, d);
+        return span<const atrvalue>(s->typedv, s->typedc);
+    }
+    /** Gives the positional arguments. */
+    span<char* const> args() const noexcept
+    {
+        return ret_ ? span<char* const>(ret_->argsv, ret_->argsc) : span<char* const>();
+    }
+    /** Gives the error messages. */
+    span<const char* const> errors() const noexcept
+    {
+        return ret_ ? span<const char* const>(ret_->errsv, ret_->errsc) : span<const char* const>();
+    }
+    /** Gives the index in argv of the argument an error is about. */
+    int error_arg(std::size_t n) const noexcept { return ret_->errsarg[n]; }
+    /** Gives the positions of the options this parse changed, compared
+     *  with the previous parse into the same result.
+     */
+    span<const std::size_t> changed() const noexcept
+    {
+        return res_ ? span<const std::size_t>(res_->changedv, res_->changedc) : span<const std::size_t>();
+    }
+    /** Gives the underlying structures, for the functions of stropt.h. */
+    const optres* c_result() const noexcept { return res_; }
+    const rtrn* c_return() const noexcept { return ret_; }
+
+private:
+    friend class parser;
+    /* Reads the slot without writing the result, the defaults going
+     * into d, so that several threads can read the same result. */
+    const optslot* slot(std::size_t n, optslot& d) const noexcept
+    {
+        static const optslot empty = {};
+        return res_ ? option_slot(res_, n, &d) : &empty;
+    }
+    void clear() noexcept
+    {
+        delete_option_result(&res_);
+        if (ret_)
+            delete_return(&ret_);
+        idx_=nullptr;
+    }
+    const optidx* idx_ = nullptr;
+    optres* res_ = nullptr;
+    rtrn* ret_ = nullptr;
+};
+
+/** Parser of a set of options.
+ *  The values are borrowed from the arguments, and response files, the
+ *  environment and configuration files are left to the atrconf
+ *  structure given by config(), whose arena members must stay unset.
+ */
+class parser
+{
+public:
+    template<std::size_t N> explicit parser(const opt (&specs)[N]) : parser(specs, N) {}
+    parser(const opt* specs, std::size_t n)
+    {
+        std::size_t i;
+        for (i=0;i<n;i++)
+            if (!valid(specs[i]))
+                throw std::invalid_argument("stropt::parser: invalid option");
+        optv_=new_option_table(n);
+        if (!optv_)
+            throw std::bad_alloc();
+        int r=0;
+        for (i=0;!r && i<n;i++)
+        {
+            option* o=optv_[i];
+            o->takes_value=specs[i].takes_value;
+            o->value_type=specs[i].value_type;
+            o->value_enum=specs[i].value_enum;
+            r=set_short_options(o, specs[i].short_act ? specs[i].short_act : "", specs[i].short_unact ? specs[i].short_unact : "");
+            if (!r)
+                r=add_long(o, 1, specs[i].long_act);
+            if (!r)
+                r=add_long(o, 0, specs[i].long_unact);
+        }
+        if (!r)
+            idx_=new_option_index(optv_);
+        if (!idx_)
+        {
+            delete_option_table(&optv_);
+            if (r > 0)
+                throw std::invalid_argument("stropt::parser: invalid option");
+            throw std::bad_alloc();
+        }
+        conf_.borrow=1;
+    }
+    parser(const parser&) = delete;
+    parser& operator=(const parser&) = delete;
+    parser(parser&& o) noexcept : optv_(o.optv_), idx_(o.idx_), conf_(o.conf_)
+    {
+        o.optv_=nullptr;
+        o.idx_=nullptr;
+    }
+    parser& operator=(parser&& o) noexcept
+    {
+        if (this != &o)
+        {
+            std::swap(optv_, o.optv_);
+            std::swap(idx_, o.idx_);
+            std::swap(conf_, o.conf_);
+        }
+        return *this;
+    }
+    ~parser()
+    {
+        delete_option_index(&idx_);
+        delete_option_table(&optv_);
+    }
+
+    /** Parses the arguments into a new result. */
+    result parse(int argc, const char* const* argv) const
+    {
+        result r;
+        parse(argc, argv, r);
+        return r;
+    }
+    /** Parses the arguments into a result, reusing the memory of the
+     *  previous parse when it was made by this parser. The arguments of
+     *  the previous parse must still be valid, to tell what changed.
+     */
+    void parse(int argc, const char* const* argv, result& r) const
+    {
+        if (r.idx_ != idx_)
+        {
+            r.clear();
+            r.res_=new_option_result(idx_);
+            if (!r.res_)
+                throw std::bad_alloc();
+            r.idx_=idx_;
+        }
+        if (r.ret_ ? atropt_reparse(r.ret_, argc, argv, idx_, r.res_, &conf_) : !(r.ret_=atropt_result(argc, argv, idx_, r.res_, &conf_)))
+        {
+            r.clear();
+            throw std::bad_alloc();
+        }
+    }
+    /** Gives the configuration of the parses. */
+    atrconf& config() noexcept { return conf_; }
+    /** Gives the underlying index, for the functions of stropt.h. */
+    const optidx* c_index() const noexcept { return idx_; }
+
+private:
+    /* As set_short_options, gives 1 for a name the library rejects, -1
+     * when the memory lacks. */
+    static int add_long(option* o, char act, const char* name) noexcept
+    {
+        if (!name)
+            return 0;
+        if (!detail::long_name(name))
+            return 1;
+        return new_long_option(o, act, name);
+    }
+
+    option** optv_ = nullptr;
+    optidx* idx_ = nullptr;
+    atrconf conf_ = {};
+};
+
+}
+
+#endif /* H_STROPT_HPP */
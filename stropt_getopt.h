@@ -0,0 +1,66 @@
+/*
+ *  Libstropt: an easy to use library about command-line options parsing
+ *  Copyright (C) 2010 Paul Bazin
+ *
+ *  This file is part of Libstrotp.
+ *
+ *  This libray is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ *  @file
+ *  getopt_long() compatible front end.
+ *  This header can be included together with getopt.h, unlike
+ *  stropt.h, whose option structure has the same name as the one of
+ *  getopt.h. The atrlongopt structure has the layout of the option
+ *  structure of getopt.h, so that a table written for getopt_long()
+ *  can be given to atropt_getopt_long() as it is.
+ *
+ *  To move a program onto Libstropt without changing its calls, define
+ *  STROPT_GETOPT_REPLACE before including this header, after getopt.h:
+ *  getopt_long() and getopt_long_only() are then macros calling the
+ *  functions of Libstropt.
+ */
+
+#ifndef H_STROPT_GETOPT
+#define H_STROPT_GETOPT
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+struct atrlongopt
+{
+    const char* name;
+    int has_arg;
+    int* flag;
+    int val;
+};
+
+int atropt_getopt_long(int,char* const*,const char*,const struct atrlongopt*,int*);
+int atropt_getopt_long_only(int,char* const*,const char*,const struct atrlongopt*,int*);
+void clear_getopt_cache(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#ifdef STROPT_GETOPT_REPLACE
+#define getopt_long(argc, argv, optstring, longopts, longindex) \
+    atropt_getopt_long((argc), (argv), (optstring), (const struct atrlongopt*) (longopts), (longindex))
+#define getopt_long_only(argc, argv, optstring, longopts, longindex) \
+    atropt_getopt_long_only((argc), (argv), (optstring), (const struct atrlongopt*) (longopts), (longindex))
+#endif
+
+#endif /* H_STROPT_GETOPT */
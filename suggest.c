@@ -0,0 +1,152 @@
+/*
+ *  Libstropt: an easy to use library about command-line options parsing
+ *  Copyright (C) 2010 Paul Bazin
+ *
+ *  This file is part of Libstrotp.
+ *
+ *  This libray is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ *  @file
+ *  Suggestions.
+ *  @author Paul Bazin
+ *  @date 2010
+ *  @version 0.9-a2
+ *
+ *  This file contains the functions looking for the long %option names
+ *  closest to an unknown one. The edit distance is computed with the
+ *  bit-parallel algorithm of Myers, as given by Hyyrö for the
+ *  Levenshtein distance: the unknown name is the pattern, held in one
+ *  machine word, and each candidate costs a few word operations per
+ *  character. The candidates are visited by length, the length
+ *  difference being a lower bound of the distance; and each name has a
+ *  signature of the characters it holds, the number of characters one
+ *  of two names has and not the other being another lower bound.
+ */
+
+#include <limits.h>
+#include "stropt.h"
+#include "index.h"
+
+#define WORD_BIT (sizeof(unsigned long)*CHAR_BIT)
+
+/** Computes the signature of a name.
+ *  Each character of the name sets one bit, chosen by its code modulo
+ *  the number of bits of a word.
+ */
+unsigned long name_sig(const char* name, size_t len)
+{
+    unsigned long sig=0;
+    size_t i;
+    for (i=0;i<len;i++)
+        sig |= 1UL << ((unsigned char) name[i] % WORD_BIT);
+    return sig;
+}
+
+/* Tells whether more than bound bits are set in x. */
+static int over(unsigned long x, size_t bound)
+{
+    size_t n=0;
+    for (;x;x&=x-1)
+        if (++n > bound)
+            return 1;
+    return 0;
+}
+
+/* Edit distance between the pattern whose match vectors are peq, of
+ * length m, and t, of length n; or bound+1 as soon as it is known to
+ * exceed bound. */
+static size_t distance(const unsigned long* peq, size_t m, const char* t, size_t n, size_t bound)
+{
+    unsigned long pv=~0UL;
+    unsigned long mv=0;
+    unsigned long hb = 1UL << (m-1);
+    size_t score=m;
+    size_t j;
+    for (j=0;j<n;j++)
+    {
+        unsigned long eq = peq[(unsigned char) t[j]];
+        unsigned long xv = eq | mv;
+        unsigned long xh = (((eq & pv) + pv) ^ pv) | eq;
+        unsigned long ph = mv | ~(xh | pv);
+        unsigned long mh = pv & xh;
+        if (ph & hb)
+            score++;
+        else if (mh & hb)
+            score--;
+        ph = (ph << 1) | 1;
+        mh <<= 1;
+        pv = mh | ~(xv | ph);
+        mv = ph & xv;
+        /* Each remaining character lowers the distance by one at
+         * most. */
+        if (score > bound + (n-j-1))
+            return bound+1;
+    }
+    return score;
+}
+
+/** Looks for the long %option names closest to an unknown one.
+ *  The names at the smallest edit distance are given, those starting
+ *  with the same letter being preferred, as long as the distance is at
+ *  most a third of the length of the name, rounded up. Names longer
+ *  than a machine word, in characters, get no suggestion.
+ *  @param[in] idx An index built with new_option_index.
+ *  @param[in] name The unknown name, which does not need to be
+ *  terminated.
+ *  @param[in] len The length of the name.
+ *  @param[out] sugv An array receiving the names suggested.
+ *  @param[in] max The size of sugv.
+ *  @return The number of names given in sugv.
+ */
+size_t suggest_options(const struct optidx* idx, const char* name, size_t len, const char** sugv, size_t max)
+{
+    unsigned long peq[UCHAR_MAX+1];
+    unsigned long sig = name_sig(name, len);
+    size_t best = 2*((len+2)/3)+1;
+    size_t sugc=0;
+    size_t i;
+    if (!len || len > WORD_BIT || !max)
+        return 0;
+    for (i=0;i<=UCHAR_MAX;i++)
+        peq[i]=0;
+    for (i=0;i<len;i++)
+        peq[(unsigned char) name[i]] |= 1UL << i;
+    for (i=0;i<idx->long_namec;i++)
+    {
+        const struct optname* nm = idx->long_bylen[i];
+        size_t diff = nm->len > len ? nm->len-len : len-nm->len;
+        size_t rank;
+        char other;
+        if (2*diff > best)
+        {
+            if (nm->len > len)
+                break;
+            continue;
+        }
+        other = nm->name[0] != name[0];
+        if (over(sig & ~nm->sig, (best-other)/2) || over(nm->sig & ~sig, (best-other)/2))
+            continue;
+        rank = 2*distance(peq, len, nm->name, nm->len, (best-other)/2) + other;
+        if (rank < best)
+        {
+            best=rank;
+            sugc=0;
+        }
+        if (rank == best && sugc < max)
+            sugv[sugc++]=nm->name;
+    }
+    return sugc;
+}
@@ -0,0 +1,215 @@
+/*
+ *  Libstropt: an easy to use library about command-line options parsing
+ *  Copyright (C) 2010 Paul Bazin
+ *
+ *  This file is part of Libstrotp.
+ *
+ *  This libray is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ *  @file
+ *  Differential test of the getopt_long() front end.
+ *  @author Paul Bazin
+ *  @date 2010
+ *  @version 0.9-a2
+ *
+ *  This program draws random optstrings, tables of long options and
+ *  argument vectors, and parses each case with glibc's getopt_long()
+ *  and getopt_long_only(), then with atropt_getopt_long() and
+ *  atropt_getopt_long_only(). Every return value, optind, optarg,
+ *  optopt, longindex and flag write must be the same, as well as the
+ *  permutation of argv and what is written on stderr. The cases are
+ *  given by a range of seeds: "getopt_diff first last", 0 and 20000 by
+ *  default. The program fails if any case differs.
+ */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <getopt.h>
+#include "stropt_getopt.h"
+
+#define MAX_ARGC 8
+#define MAX_LONG 7
+#define OUT_SIZE 65536
+
+static const char* names[] = {"a", "ab", "abc", "abd", "b", "b-c", "bc", "x", "", "W", "alpha", "al"};
+static const char* tokens[] = {"-a", "-ab", "-abc", "--a", "--ab", "--ab=x", "--abc=", "-", "--", "x",
+                               "y", "-W", "ab", "-Wab", "--b", "-b=x", "-:", "--=x", "-cx", "-ax",
+                               "--al", "--alp", "-al", "-alpha", "--bc", "--b-", "-x", "--x=1", "-Wx=2",
+                               "-W", "-;", "--W", "-c", "-xa", "--abd", "--ab=", "-b"};
+static const char* prefixes[] = {"", "", "", "+", "-", ":", "+:", "-:"};
+static char prog[] = "prog";
+
+static unsigned long seed;
+static int flags[3];
+
+/* A linear congruential generator, the same on every platform. */
+static unsigned draw(unsigned n)
+{
+    seed = (seed*1103515245UL + 12345UL) & 0xffffffffUL;
+    return (unsigned) ((seed >> 16) % n);
+}
+
+struct trace
+{
+    char text[OUT_SIZE];
+    size_t len;
+};
+
+static void append(struct trace* tr, const char* s)
+{
+    size_t len=strlen(s);
+    if (tr->len+len >= OUT_SIZE)
+        len=OUT_SIZE-1-tr->len;
+    memcpy(tr->text+tr->len, s, len);
+    tr->len+=len;
+    tr->text[tr->len]='\0';
+}
+
+/* Parses argv to the end, writing down all that the caller can see. */
+static void run(char ours, char long_only, int argc, char** argv, const char* optstring, const struct option* longopts, struct trace* tr)
+{
+    char buf[4096];
+    FILE* err=tmpfile();
+    int saved;
+    int c;
+    int i;
+    size_t n;
+    if (!err)
+    {
+        perror("tmpfile");
+        exit(EXIT_FAILURE);
+    }
+    fflush(stderr);
+    saved=dup(2);
+    dup2(fileno(err), 2);
+    optind=0;
+    opterr=1;
+    flags[0]=flags[1]=flags[2]=-1;
+    tr->len=0;
+    tr->text[0]='\0';
+    do
+    {
+        int longindex=-7;
+        if (ours)
+            c = long_only ? atropt_getopt_long_only(argc, argv, optstring, (const struct atrlongopt*) longopts, &longindex)
+                          : atropt_getopt_long(argc, argv, optstring, (const struct atrlongopt*) longopts, &longindex);
+        else
+            c = long_only ? getopt_long_only(argc, argv, optstring, longopts, &longindex)
+                          : getopt_long(argc, argv, optstring, longopts, &longindex);
+        sprintf(buf, "[c=%d i=%d o=%d l=%d f=%d a=", c, optind, c == '?' || c == ':' ? optopt : 0,
+                longindex, flags[0]*10000+flags[1]*100+flags[2]);
+        append(tr, buf);
+        append(tr, optarg ? optarg : "(null)");
+        append(tr, "]");
+    }
+    while (c != -1);
+    for (i=0;i<argc;i++)
+    {
+        append(tr, " ");
+        append(tr, argv[i]);
+    }
+    fflush(stderr);
+    dup2(saved, 2);
+    close(saved);
+    rewind(err);
+    n=fread(buf, 1, sizeof buf - 1, err);
+    buf[n]='\0';
+    fclose(err);
+    append(tr, "\nstderr: ");
+    append(tr, buf);
+}
+
+int main(int argc, char** argv)
+{
+    static struct trace ref;
+    static struct trace got;
+    unsigned long first = argc > 1 ? strtoul(argv[1], NULL, 10) : 0;
+    unsigned long last = argc > 2 ? strtoul(argv[2], NULL, 10) : 20000;
+    unsigned long fails=0;
+    unsigned long s;
+    for (s=first;s<last;s++)
+    {
+        struct option longopts[MAX_LONG+1];
+        char optstring[32];
+        char* argv1[MAX_ARGC+1];
+        char* argv2[MAX_ARGC+1];
+        const char* p;
+        int len=0;
+        int longc;
+        int n;
+        int i;
+        char long_only;
+        char no_table;
+        seed=s;
+        longc=draw(MAX_LONG);
+        n=1+draw(MAX_ARGC-1);
+        long_only=draw(2);
+        no_table=!draw(10);
+        if (!draw(8))
+            setenv("POSIXLY_CORRECT", "1", 1);
+        else
+            unsetenv("POSIXLY_CORRECT");
+        for (p=prefixes[draw(sizeof prefixes/sizeof *prefixes)];*p;p++)
+            optstring[len++]=*p;
+        for (i=draw(5);i>0;i--)
+        {
+            optstring[len++]="abcxW"[draw(5)];
+            switch (draw(5))
+            {
+            case 0:
+                optstring[len++]=':';
+                break;
+            case 1:
+                optstring[len++]=':';
+                optstring[len++]=':';
+                break;
+            case 2:
+                optstring[len++]=';';
+                break;
+            default:
+                break;
+            }
+        }
+        optstring[len]='\0';
+        for (i=0;i<longc;i++)
+        {
+            longopts[i].name=names[draw(sizeof names/sizeof *names)];
+            longopts[i].has_arg=draw(3);
+            longopts[i].flag = draw(4) ? NULL : flags+draw(3);
+            longopts[i].val="aabx\0W"[draw(6)] + (draw(3) ? 0 : 300);
+        }
+        memset(longopts+longc, 0, sizeof *longopts);
+        argv1[0]=argv2[0]=prog;
+        for (i=1;i<n;i++)
+            argv1[i]=argv2[i]=(char*) tokens[draw(sizeof tokens/sizeof *tokens)];
+        argv1[n]=argv2[n]=NULL;
+        run(0, long_only, n, argv1, optstring, no_table ? NULL : longopts, &ref);
+        run(1, long_only, n, argv2, optstring, no_table ? NULL : longopts, &got);
+        clear_getopt_cache();
+        if (strcmp(ref.text, got.text) && fails++ < 5)
+        {
+            printf("seed %lu, optstring \"%s\"%s:", s, optstring, long_only ? ", long only" : "");
+            for (i=1;i<n;i++)
+                printf(" %s", argv1[i]);
+            printf("\nglibc:     %s\nlibstropt: %s\n", ref.text, got.text);
+        }
+    }
+    printf("getopt_diff: %lu cases, %lu differ\n", last-first, fails);
+    return fails ? EXIT_FAILURE : EXIT_SUCCESS;
+}
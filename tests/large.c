@@ -0,0 +1,181 @@
+/*
+ *  Libstropt: an easy to use library about command-line options parsing
+ *  Copyright (C) 2010 Paul Bazin
+ *
+ *  This file is part of Libstrotp.
+ *
+ *  This libray is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ *  @file
+ *  Large-scale test of the parser.
+ *  @author Paul Bazin
+ *  @date 2010
+ *  @version 0.9-a2
+ *
+ *  This program parses 2,000,000 arguments against 100,000 long
+ *  options, first into the option structures, then into a result
+ *  structure. A quarter of the arguments are positional, a quarter
+ *  values of the same option, a quarter flags spread over all the other
+ *  options, and a quarter unknown options: argsc, errsc and valuec must
+ *  all go well past 65535, and every positional argument, error and
+ *  value must be found at its place.
+ */
+
+#include <stdio.h>
+#include "stropt.h"
+
+#define ARGC 2000000
+#define OPTC 100000
+#define ARG_SIZE 24
+
+static char arg0[] = "large";
+static unsigned long failures;
+
+static void check(int ok, const char* what, size_t n)
+{
+    if (!ok && failures++ < 10)
+        printf("large: wrong %s at %lu\n", what, (unsigned long)n);
+}
+
+/* Checks that each argument went where its kind sends it. The flags
+ * are checked here for a parse into a result structure only. */
+static void check_parse(const struct rtrn* ret, char** argv, char** valuev, size_t valuec, const struct optres* res)
+{
+    struct optslot dflt;
+    size_t argn=0;
+    size_t errn=0;
+    size_t valn=0;
+    size_t i;
+    for (i=1;i<ARGC;i++)
+    {
+        char buf[ARG_SIZE];
+        switch (i%4)
+        {
+        case 0:
+            check(argn < ret->argsc && !strcmp(ret->argsv[argn], argv[i]), "positional argument", i);
+            argn++;
+            break;
+        case 1:
+            sprintf(buf, "v%lu", (unsigned long)i);
+            check(valn < valuec && !strcmp(valuev[valn], buf), "value", i);
+            valn++;
+            break;
+        case 2:
+            if (res)
+                check(option_slot(res, 1+(i/4)%(OPTC-1), &dflt)->active, "flag", i);
+            break;
+        default:
+            check(errn < ret->errsc && ret->errsarg[errn] == (int)i, "error", i);
+            errn++;
+            break;
+        }
+    }
+    check(ret->argsc == argn && argn > 65535, "argsc", ret->argsc);
+    check(ret->errsc == errn && errn > 65535, "errsc", ret->errsc);
+    check(valuec == valn && valn > 65535, "valuec", valuec);
+    check(ret->argsv[argn] == NULL, "end of argsv", argn);
+    check(valuev[valn] == NULL, "end of valuev", valn);
+}
+
+/* Builds the table: o0 takes several values, the others none. */
+static struct option** build_table(void)
+{
+    static char names[OPTC][ARG_SIZE];
+    struct option** optv = new_option_table(OPTC);
+    size_t i;
+    for (i=0;optv && i<OPTC;i++)
+    {
+        sprintf(names[i], "o%lu", (unsigned long)i);
+        if (new_long_option(optv[i], 1, names[i]))
+            delete_option_table(&optv);
+    }
+    if (optv)
+        optv[0]->takes_value=2;
+    return optv;
+}
+
+int main(void)
+{
+    char** argv = malloc((sizeof *argv)*(ARGC+1));
+    char* buf = malloc(ARG_SIZE*ARGC);
+    struct option** optv = build_table();
+    struct optidx* idx;
+    struct optres* res;
+    struct rtrn* ret;
+    struct optslot dflt;
+    const struct optslot* slot;
+    size_t i;
+    if (!argv || !buf || !optv)
+    {
+        fputs("large: out of memory\n", stderr);
+        return EXIT_FAILURE;
+    }
+    argv[0]=arg0;
+    for (i=1;i<ARGC;i++)
+    {
+        argv[i]=buf+ARG_SIZE*i;
+        switch (i%4)
+        {
+        case 0:
+            sprintf(argv[i], "file%lu", (unsigned long)i);
+            break;
+        case 1:
+            sprintf(argv[i], "--o0=v%lu", (unsigned long)i);
+            break;
+        case 2:
+            sprintf(argv[i], "--o%lu", (unsigned long)(1+(i/4)%(OPTC-1)));
+            break;
+        default:
+            sprintf(argv[i], "--x%lu", (unsigned long)i);
+            break;
+        }
+    }
+    argv[ARGC]=NULL;
+    idx=new_option_index(optv);
+    ret = idx ? atropt_index(ARGC, argv, idx) : NULL;
+    if (!ret)
+    {
+        fputs("large: out of memory\n", stderr);
+        return EXIT_FAILURE;
+    }
+    for (i=1;i<OPTC;i++)
+        check(optv[i]->active, "flag", i);
+    check_parse(ret, argv, optv[0]->valuev, optv[0]->valuec, NULL);
+    delete_return(&ret);
+    delete_option_index(&idx);
+    delete_option_table(&optv);
+
+    /* The same parse into a result structure, from a fresh table. */
+    optv=build_table();
+    idx = optv ? new_option_index(optv) : NULL;
+    res = idx ? new_option_result(idx) : NULL;
+    ret = res ? atropt_result(ARGC, (const char* const*)argv, idx, res, NULL) : NULL;
+    if (!ret)
+    {
+        fputs("large: out of memory\n", stderr);
+        return EXIT_FAILURE;
+    }
+    slot=option_slot(res, 0, &dflt);
+    check_parse(ret, argv, slot->valuev, slot->valuec, res);
+    delete_return(&ret);
+    delete_option_result(&res);
+    delete_option_index(&idx);
+    delete_option_table(&optv);
+    free(argv);
+    free(buf);
+    printf("large: %d arguments, %d options, %lu failures\n", ARGC, OPTC, failures);
+    return failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
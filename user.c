@@ -33,9 +33,13 @@
  */
 
 #include "stropt.h"
+#include "respfile.h"
+#include "scan.h"
+#include "store.h"
 
 void* smalloc(size_t);
 void* srealloc(void*, size_t);
+void sfree(void*);
 
 /** Creates an option structure.
  *  This function will alloc memory needed for a struct option,
@@ -56,6 +60,15 @@ struct option* new_option(void)
         opt->takes_value=0;
         opt->valuec=0;
         opt->value=NULL;
+        opt->value_ext=0;
+        opt->values=NULL;
+        opt->borrow=0;
+        opt->value_len=0;
+        opt->value_type=ATR_STRING;
+        opt->value_enum=NULL;
+        opt->typedv=NULL;
+        opt->typedc=0;
+        opt->source=ATR_SRC_DEFAULT;
         opt->short_act = smalloc(sizeof *opt->short_act);
         opt->short_unact = smalloc(sizeof *opt->short_unact);
         opt->long_act = smalloc(sizeof *opt->long_act);
@@ -71,12 +84,12 @@ struct option* new_option(void)
         }
         else
         {
-            free(opt->short_act);
-            free(opt->short_unact);
-            free(opt->long_act);
-            free(opt->long_unact);
-            free(opt->valuev);
-            free(opt);
+            sfree(opt->short_act);
+            sfree(opt->short_unact);
+            sfree(opt->long_act);
+            sfree(opt->long_unact);
+            sfree(opt->valuev);
+            sfree(opt);
             opt=NULL;
         }
     }
@@ -102,19 +115,11 @@ struct option* new_option(void)
 int set_short_options(struct option* ptr, const char* act, const char* unact)
 {
     int r=0;
-    int k;
-    char ok=1;
-    int i=strlen(act);
-    int j=strlen(unact);
-    free(ptr->short_act);
-    free(ptr->short_unact);
-    for (k=0;k<i;k++)
-        if (!isgraph(act[k]) || act[k]=='-')
-            ok=0;
-    for (k=0;k<j;k++)
-        if (!isgraph(unact[k]) || unact[k]=='-')
-            ok=0;
-    if (ok)
+    size_t i=strlen(act);
+    size_t j=strlen(unact);
+    sfree(ptr->short_act);
+    sfree(ptr->short_unact);
+    if (scan_graph(act, i) == i && scan_graph(unact, j) == j)
     {
         ptr->short_act = smalloc((sizeof *ptr->short_act)*(i+1));
         if (ptr->short_act)
@@ -150,14 +155,11 @@ int set_short_options(struct option* ptr, const char* act, const char* unact)
 int new_long_option(struct option* ptr, char act, const char* str)
 {
     int r=0;
-    int i=-1;
+    int i=0;
     const char*** long_;
-    while (str[++i] != '\0')
-        if (str[i] == '=')
-            r=-1;
-    if (!i)
+    const char* end=scan_eq(str);
+    if (*end || end == str)
         r=-1;
-    i=0;
     if (!r)
     {
         const char** tmp;
@@ -194,15 +196,15 @@ void delete_option(struct option** ptr)
 {
     if (*ptr)
     {
-        int i=0;
-        free((*ptr)->short_act);
-        free((*ptr)->short_unact);
-        free((*ptr)->long_act);
-        free((*ptr)->long_unact);
-        while (((*ptr)->valuev)[i])
-            free(((*ptr)->valuev)[i++]);
-        free((*ptr)->valuev);
-        free(*ptr);
+        sfree((*ptr)->short_act);
+        sfree((*ptr)->short_unact);
+        sfree((*ptr)->long_act);
+        sfree((*ptr)->long_unact);
+        free_values(*ptr);
+        sfree((*ptr)->typedv);
+        if (!(*ptr)->value_ext)
+            sfree((*ptr)->value);
+        sfree(*ptr);
         *ptr=NULL;
     }
 }
@@ -222,9 +224,9 @@ void delete_option(struct option** ptr)
  *  @return A pointer to an array of pointers to option structures, or
  *  NULL on a failure.
  */
-struct option** new_option_table(int n)
+struct option** new_option_table(size_t n)
 {
-    int i;
+    size_t i;
     struct option** opt_tab = smalloc((sizeof *opt_tab)*(n+1));
     if (opt_tab)
     {
@@ -254,20 +256,34 @@ void delete_option_table(struct option*** ptr)
 {
     if (*ptr)
     {
-        int i;
+        size_t i;
         for (i=0;(*ptr)[i]!=NULL;i++)
             delete_option(*ptr+i);
-        free(*ptr);
+        sfree(*ptr);
         *ptr=NULL;
     }
 }
 
 void delete_return(struct rtrn** ptr)
 {
-    free((*ptr)->argsv);
-    free((*ptr)->errsv);
-    free((*ptr)->errsarg);
-    free(*ptr);
+    close_respfiles((*ptr)->files);
+    close_respfiles((*ptr)->prev_files);
+    if ((*ptr)->arena)
+    {
+        struct arena* arena = (*ptr)->arena;
+        if ((*ptr)->arena_owned)
+            delete_arena(&arena);
+    }
+    else
+    {
+        sfree((*ptr)->argsv);
+        sfree((*ptr)->errsv);
+        sfree((*ptr)->errsarg);
+        sfree((*ptr)->argspos);
+        sfree((*ptr)->errspos);
+        sfree((*ptr)->errshint);
+        sfree(*ptr);
+    }
     *ptr=NULL;
 }
 
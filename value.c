@@ -0,0 +1,373 @@
+/*
+ *  Libstropt: an easy to use library about command-line options parsing
+ *  Copyright (C) 2010 Paul Bazin
+ *
+ *  This file is part of Libstrotp.
+ *
+ *  This libray is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ *  @file
+ *  Typed values.
+ *  @author Paul Bazin
+ *  @date 2010
+ *  @version 0.9-a2
+ *
+ *  This file contains the functions decoding the values of the options
+ *  which declare a value type. They only know ASCII digits, a '.' as
+ *  decimal point and the suffixes listed below, whatever the locale.
+ */
+
+#include <limits.h>
+#include <float.h>
+#include <locale.h>
+#include "stropt.h"
+#include "value.h"
+
+/* Powers of ten exactly represented by a double. */
+static const double pow10[] = {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+static int digit(char c, unsigned int base)
+{
+    if (c >= '0' && c <= '9')
+        return c-'0';
+    if (base == 16 && c >= 'a' && c <= 'f')
+        return c-'a'+10;
+    if (base == 16 && c >= 'A' && c <= 'F')
+        return c-'A'+10;
+    return -1;
+}
+
+static char lower(char c)
+{
+    if (c >= 'A' && c <= 'Z')
+        return c-'A'+'a';
+    return c;
+}
+
+/* Compares s with the lower case word w, ignoring the case of s. */
+static int same_word(const char* s, const char* w)
+{
+    while (*w && lower(*s) == *w)
+    {
+        s++;
+        w++;
+    }
+    return !*s && !*w;
+}
+
+/* Reads a decimal, or hexadecimal after "0x", unsigned number from
+ * *ps, moving *ps after it. Returns 0, 1 if there is no digit, or 2 on
+ * an overflow. */
+static int read_ulong(const char** ps, unsigned long* out)
+{
+    const char* s=*ps;
+    unsigned long n=0;
+    unsigned int base=10;
+    int d;
+    char range=0;
+    if (s[0] == '0' && (s[1] == 'x' || s[1] == 'X') && digit(s[2], 16) >= 0)
+    {
+        base=16;
+        s+=2;
+    }
+    if (digit(*s, base) < 0)
+        return 1;
+    for (;(d = digit(*s, base)) >= 0;s++)
+    {
+        if (n > (ULONG_MAX - d)/base)
+            range=1;
+        else
+            n = n*base + d;
+    }
+    *ps=s;
+    *out=n;
+    return range ? 2 : 0;
+}
+
+/* Converts the number from start to end with strtod, the '.' being
+ * replaced by the decimal point of the locale. Returns 0 if the number
+ * is too long to be copied. */
+static int locale_double(const char* start, const char* end, double* out)
+{
+    char buf[128];
+    const char* point = localeconv()->decimal_point;
+    size_t plen = strlen(point);
+    size_t n=0;
+    if ((size_t) (end-start) + plen >= sizeof buf)
+        return 0;
+    for (;start<end;start++)
+        if (*start == '.')
+        {
+            memcpy(buf+n, point, plen);
+            n+=plen;
+        }
+        else
+            buf[n++]=*start;
+    buf[n]='\0';
+    *out=strtod(buf, NULL);
+    return 1;
+}
+
+/* Reads a decimal floating point number from *ps, moving *ps after it.
+ * Up to 15 significant digits and an exponent up to 22 in magnitude,
+ * the result is computed directly, exactly rounded; beyond, strtod is
+ * used. Returns 0, 1 if there is no digit, or 2 on an overflow. */
+static int read_double(const char** ps, double* out)
+{
+    const char* start=*ps;
+    const char* s=*ps;
+    unsigned long m=0;
+    long exp=0;
+    int digits=0;
+    char neg=0;
+    double v;
+    if (*s == '-' || *s == '+')
+        neg = *s++ == '-';
+    for (;*s >= '0' && *s <= '9';s++,digits++)
+    {
+        if (m <= (ULONG_MAX - 9)/10)
+            m = m*10 + (*s-'0');
+        else
+            exp++;
+    }
+    if (*s == '.')
+        for (s++;*s >= '0' && *s <= '9';s++,digits++)
+            if (m <= (ULONG_MAX - 9)/10)
+            {
+                m = m*10 + (*s-'0');
+                exp--;
+            }
+    if (!digits)
+        return 1;
+    if ((*s == 'e' || *s == 'E') && (digit(s[1], 10) >= 0 || ((s[1] == '-' || s[1] == '+') && digit(s[2], 10) >= 0)))
+    {
+        long e=0;
+        char eneg=0;
+        s++;
+        if (*s == '-' || *s == '+')
+            eneg = *s++ == '-';
+        for (;*s >= '0' && *s <= '9';s++)
+            if (e < 100000)
+                e = e*10 + (*s-'0');
+        exp += eneg ? -e : e;
+    }
+    v=(double) m;
+    if (m && (m > 9007199254740992.0 || exp > 22 || exp < -22) && locale_double(start, s, &v))
+        neg=0; /* strtod read the sign too */
+    else if (m)
+    {
+        while (exp > 22)
+        {
+            v*=pow10[22];
+            exp-=22;
+        }
+        while (exp < -22)
+        {
+            v/=pow10[22];
+            exp+=22;
+        }
+        if (exp >= 0)
+            v*=pow10[exp];
+        else
+            v/=pow10[-exp];
+    }
+    *ps=s;
+    *out = neg ? -v : v;
+    if (v > DBL_MAX || v < -DBL_MAX)
+        return 2;
+    return 0;
+}
+
+static int decode_int(const char* s, union atrvalue* out)
+{
+    unsigned long n;
+    char neg=0;
+    int r;
+    if (*s == '-' || *s == '+')
+        neg = *s++ == '-';
+    r=read_ulong(&s, &n);
+    if (!r && *s)
+        r=1;
+    if (!r)
+    {
+        if (!neg && n > (unsigned long) LONG_MAX)
+            r=2;
+        else if (neg && n > (unsigned long) LONG_MAX + 1)
+            r=2;
+        else if (neg && n)
+            out->i = -(long) (n-1) - 1;
+        else
+            out->i = (long) n;
+    }
+    return r;
+}
+
+static int decode_uint(const char* s, union atrvalue* out)
+{
+    int r;
+    if (*s == '+')
+        s++;
+    r=read_ulong(&s, &out->u);
+    if (!r && *s)
+        r=1;
+    return r;
+}
+
+/* A size: a number of bytes, possibly followed by K, M, G or T, for
+ * binary multiples, then "B" or "iB". */
+static int decode_size(const char* s, union atrvalue* out)
+{
+    static const char units[] = "kmgt";
+    unsigned long n;
+    int shift=0;
+    int r;
+    if (*s == '+')
+        s++;
+    r=read_ulong(&s, &n);
+    if (r == 1)
+        return r;
+    if (*s)
+    {
+        const char* u;
+        for (u=units;*u && *u != lower(*s);u++);
+        if (*u)
+        {
+            shift = u-units+1;
+            s++;
+            if (s[0] == 'i' && s[1] == 'B')
+                s+=2;
+            else if (s[0] == 'B')
+                s++;
+        }
+        else if (s[0] == 'B')
+            s++;
+    }
+    if (*s)
+        return 1;
+    for (;shift;shift--)
+    {
+        if (n > ULONG_MAX/1024)
+            r=2;
+        n*=1024;
+    }
+    out->u=n;
+    return r;
+}
+
+/* A duration, in seconds unless followed by ns, us, ms, s, m, h or d.
+ * It is stored in seconds. */
+static int decode_duration(const char* s, union atrvalue* out)
+{
+    static const char* units[] = {"ns", "us", "ms", "s", "m", "h", "d", NULL};
+    static const double scale[] = {1e-9, 1e-6, 1e-3, 1, 60, 3600, 86400};
+    double d;
+    int r;
+    int u;
+    if (*s == '-')
+        return 1;
+    r=read_double(&s, &d);
+    if (r == 1)
+        return r;
+    if (*s)
+    {
+        for (u=0;units[u] && !same_word(s, units[u]);u++);
+        if (!units[u])
+            return 1;
+        d*=scale[u];
+        if (d > DBL_MAX)
+            r=2;
+    }
+    out->d=d;
+    return r;
+}
+
+static int decode_bool(const char* s, union atrvalue* out)
+{
+    static const char* yes[] = {"1", "y", "yes", "true", "on", NULL};
+    static const char* no[] = {"0", "n", "no", "false", "off", NULL};
+    int i;
+    for (i=0;yes[i];i++)
+        if (same_word(s, yes[i]))
+        {
+            out->b=1;
+            return 0;
+        }
+    for (i=0;no[i];i++)
+        if (same_word(s, no[i]))
+        {
+            out->b=0;
+            return 0;
+        }
+    return 1;
+}
+
+static int decode_enum(const char* s, const char* const* enumv, union atrvalue* out)
+{
+    int i;
+    for (i=0;enumv && enumv[i];i++)
+        if (!strcmp(s, enumv[i]))
+        {
+            out->e=i;
+            return 0;
+        }
+    return 1;
+}
+
+/** Decodes a value according to a value type.
+ *  @param[in] s The value.
+ *  @param[in] type One of the atrtype constants.
+ *  @param[in] enumv For ATR_ENUM, the names allowed, terminated by
+ *  NULL.
+ *  @param[out] out The decoded value.
+ *  @return 0 on a success, 1 if the value is invalid, 2 if it is out of
+ *  the range of its type.
+ */
+int decode_value(const char* s, char type, const char* const* enumv, union atrvalue* out)
+{
+    int r=0;
+    double d=0;
+    switch (type)
+    {
+        case ATR_INT:
+            r=decode_int(s, out);
+            break;
+        case ATR_UINT:
+            r=decode_uint(s, out);
+            break;
+        case ATR_DOUBLE:
+            r=read_double(&s, &d);
+            if (r != 1 && *s)
+                r=1;
+            out->d=d;
+            break;
+        case ATR_BOOL:
+            r=decode_bool(s, out);
+            break;
+        case ATR_SIZE:
+            r=decode_size(s, out);
+            break;
+        case ATR_DURATION:
+            r=decode_duration(s, out);
+            break;
+        case ATR_ENUM:
+            r=decode_enum(s, enumv, out);
+            break;
+    }
+    return r;
+}